@@ -27,15 +27,137 @@
     #define PACKET_XOR_TYPE
 #endif // _MSC_VER
 
+#include <cstddef>
 #include <cstdint>
 #include <list>
 #include <vector>
 
 class PacketXorDividerImpl;
 class PacketXorUnifierImpl;
+class PacketXorStriperImpl;
+class PacketXorFanoutImpl;
+
+struct fanout_packet_t
+{
+    const uint8_t         * head_data;
+    uint32_t                head_size;
+    const uint8_t         * body_data;
+    uint32_t                body_size;
+};
 
 typedef void (*encode_callback_t)(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
 typedef void (*decode_callback_t)(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+typedef uint8_t * (*reserve_callback_t)(void * user_data, uint32_t dst_size);
+typedef void (*nack_callback_t)(void * user_data, const uint8_t * nack_data, uint32_t nack_size);
+typedef void (*progress_callback_t)(void * user_data, uint64_t group_index, uint32_t group_offset, const uint8_t * data, uint32_t size, uint32_t group_size);
+typedef void (*complete_callback_t)(void * user_data, uint64_t group_index, uint32_t group_size, bool delivered);
+typedef void (*object_callback_t)(void * user_data, uint32_t object_id, uint64_t object_offset, uint32_t window_size, uint64_t object_size);
+typedef void (*stripe_callback_t)(void * user_data, uint32_t path_index, const uint8_t * dst_data, uint32_t dst_size);
+typedef bool (*send_callback_t)(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+typedef void (*fanout_callback_t)(void * user_data, uint32_t session_id, const fanout_packet_t * dst_packets, uint32_t dst_count);
+
+struct unifier_stats_t
+{
+    uint64_t                checksum_error_blocks;
+    uint64_t                memory_budget_bytes;
+    uint64_t                memory_used_bytes;
+    uint64_t                memory_peak_bytes;
+    uint64_t                rejected_groups;
+    uint64_t                evicted_groups;
+    uint64_t                nack_messages;
+    uint64_t                nack_blocks;
+    double                  gap_average_microseconds;
+    double                  gap_deviation_microseconds;
+    double                  spread_average_microseconds;
+    double                  spread_deviation_microseconds;
+    uint64_t                object_windows;
+    uint64_t                object_dropped_windows;
+    uint64_t                parity_recovered_groups;
+    uint64_t                xor_processed_bytes;
+    uint64_t                stream_recovered_blocks;
+};
+
+struct path_stats_t
+{
+    uint64_t                received_blocks;
+    uint64_t                received_bytes;
+    uint64_t                lost_blocks;
+    double                  relative_delay_microseconds;
+    double                  jitter_microseconds;
+};
+
+struct sender_stats_t
+{
+    uint64_t                queued_frames;
+    uint64_t                queued_bytes;
+    uint64_t                sent_frames;
+    uint64_t                sent_bytes;
+    uint64_t                dropped_frames;
+    uint64_t                dropped_bytes;
+    uint64_t                failed_frames;
+    uint64_t                failed_bytes;
+    double                  queue_delay_average_microseconds;
+    uint64_t                queue_delay_max_microseconds;
+};
+
+struct block_view_t
+{
+    uint64_t                group_index;
+    uint32_t                block_index;
+    uint32_t                block_count;
+    uint32_t                block_bytes;
+    uint32_t                block_pos;
+    uint32_t                group_bytes;
+    uint32_t                head_offset;
+    uint32_t                head_bytes;
+    uint8_t                 protocol_id;
+    uint8_t                 ext_flags;
+    uint8_t                 frame_class;
+    uint16_t                deadline_millisecond;
+    uint32_t                checksum;
+};
+
+struct replay_stats_t
+{
+    uint64_t                trace_records;
+    uint64_t                trace_datagrams;
+    uint64_t                trace_microseconds;
+    uint64_t                delivered_frames;
+    uint64_t                delivered_bytes;
+    uint64_t                nack_nanoseconds;
+    uint64_t                insert_nanoseconds;
+    uint64_t                deliver_nanoseconds;
+};
+
+class PACKET_XOR_TYPE PacketBatch
+{
+public:
+    PacketBatch();
+
+public:
+    void clear();
+    void reserve(std::size_t packet_count, std::size_t arena_bytes);
+    void swap(PacketBatch & other);
+
+public:
+    std::size_t size() const;
+    bool empty() const;
+    const uint8_t * data(std::size_t packet_index) const;
+    uint32_t length(std::size_t packet_index) const;
+    std::size_t offset(std::size_t packet_index) const;
+    const uint8_t * arena() const;
+    std::size_t arena_size() const;
+
+public:
+    uint8_t * append(uint32_t packet_length);
+    void append(const uint8_t * packet_data, uint32_t packet_length);
+
+private:
+    std::vector<uint8_t>        m_arena;
+    std::size_t                 m_arena_size;
+    std::vector<std::size_t>    m_offsets;
+    std::vector<uint32_t>       m_lengths;
+};
 
 class PACKET_XOR_TYPE PacketXorDivider
 {
@@ -48,12 +170,49 @@ public:
     ~PacketXorDivider();
 
 public:
-    bool init(uint32_t max_block_size, bool use_xor);
+    bool init(uint32_t max_block_size, bool use_xor, bool use_crc = false);
     void exit();
 
 public:
     bool encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
     bool encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data);
+    bool encode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch);
+
+public:
+    bool set_frame_class(uint8_t frame_class, uint32_t xor_stride, uint32_t deadline_millisecond);
+    bool encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, std::list<std::vector<uint8_t>> & dst_list);
+    bool encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, encode_callback_t encode_callback, void * user_data);
+    bool encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, PacketBatch & dst_batch);
+
+public:
+    bool set_aggregation(uint32_t max_message_size, uint32_t max_delay_millisecond);
+    bool poll(std::list<std::vector<uint8_t>> & dst_list);
+    bool poll(encode_callback_t encode_callback, void * user_data);
+    bool poll(PacketBatch & dst_batch);
+    bool flush(std::list<std::vector<uint8_t>> & dst_list);
+    bool flush(encode_callback_t encode_callback, void * user_data);
+    bool flush(PacketBatch & dst_batch);
+
+public:
+    bool set_retransmit(uint32_t cache_block_count);
+    bool resend(const uint8_t * nack_data, uint32_t nack_size, std::list<std::vector<uint8_t>> & dst_list);
+    bool resend(const uint8_t * nack_data, uint32_t nack_size, encode_callback_t encode_callback, void * user_data);
+    bool resend(const uint8_t * nack_data, uint32_t nack_size, PacketBatch & dst_batch);
+
+public:
+    bool set_cross_parity(uint32_t window_groups, uint32_t max_delay_millisecond);
+    bool set_stream_fec(uint32_t window_blocks, uint32_t repair_interval);
+
+public:
+    bool set_send_queue(uint64_t max_queue_bytes, uint32_t max_queue_millisecond, uint32_t frame_deadline_millisecond);
+    bool enqueue(const uint8_t * src_data, uint32_t src_size);
+    bool enqueue(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class);
+    bool send(send_callback_t send_callback, void * user_data);
+    void get_send_stats(sender_stats_t & stats) const;
+
+public:
+    bool encode_object(const uint8_t * object_data, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data);
+    bool encode_object(int file_descriptor, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data);
 
 public:
     void reset();
@@ -73,15 +232,50 @@ public:
     ~PacketXorUnifier();
 
 public:
-    bool init(uint32_t expire_millisecond = 15, double fault_tolerance_rate = 0.0);
+    bool init(uint32_t expire_millisecond = 15, double fault_tolerance_rate = 0.0, uint64_t memory_budget_bytes = 0, uint32_t max_group_bytes = 0);
     void exit();
 
 public:
     bool decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
     bool decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data);
+    bool decode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch);
+    bool decode(const uint8_t * src_data, uint32_t src_size, reserve_callback_t reserve_callback, decode_callback_t commit_callback, void * user_data);
+    bool decode(const PacketBatch & src_batch, const std::vector<block_view_t> & block_views, PacketBatch & dst_batch);
+
+public:
+    // Times are microseconds of std::chrono::steady_clock (CLOCK_MONOTONIC on Linux), never the wall clock:
+    // arm a timerfd for next_deadline() with CLOCK_MONOTONIC and TFD_TIMER_ABSTIME, and pass current_microsecond() to poll().
+    uint64_t next_deadline() const;
+    bool poll(uint64_t now_microsecond, std::list<std::vector<uint8_t>> & dst_list);
+    bool poll(uint64_t now_microsecond, decode_callback_t decode_callback, void * user_data);
+    bool poll(uint64_t now_microsecond, PacketBatch & dst_batch);
+    static uint64_t current_microsecond();
 
 public:
     static bool recognizable(const uint8_t * src_data, uint32_t src_size);
+    static std::size_t classify(const PacketBatch & src_batch, std::vector<uint64_t> & valid_mask, std::vector<block_view_t> & block_views);
+
+public:
+    bool set_nack(uint32_t nack_delay_millisecond, nack_callback_t nack_callback, void * user_data);
+    bool set_adaptive_expiry(uint32_t min_expire_millisecond, uint32_t max_expire_millisecond, double jitter_factor = 4.0);
+    bool set_lazy_recovery(bool lazy_recovery, uint32_t margin_millisecond = 2);
+
+public:
+    bool set_object_output(const char * file_path, object_callback_t object_callback = nullptr, void * user_data = nullptr);
+
+public:
+    bool set_progress(progress_callback_t progress_callback, complete_callback_t complete_callback, void * user_data);
+
+public:
+    bool set_trace(const char * trace_path, bool with_payload = false);
+    bool replay(const char * trace_path, decode_callback_t decode_callback, void * user_data, replay_stats_t & stats);
+
+public:
+    void get_stats(unifier_stats_t & stats) const;
+    bool get_path_stats(uint32_t path_index, path_stats_t & stats) const;
+
+public:
+    void recycle(std::vector<uint8_t> && frame);
 
 public:
     void reset();
@@ -90,5 +284,65 @@ private:
     PacketXorUnifierImpl  * m_unifier;
 };
 
+class PACKET_XOR_TYPE PacketXorStriper
+{
+public:
+    PacketXorStriper();
+    PacketXorStriper(const PacketXorStriper &) = delete;
+    PacketXorStriper(PacketXorStriper &&) = delete;
+    PacketXorStriper & operator = (const PacketXorStriper &) = delete;
+    PacketXorStriper & operator = (PacketXorStriper &&) = delete;
+    ~PacketXorStriper();
+
+public:
+    bool init(uint32_t path_count, const uint32_t * path_weights, stripe_callback_t stripe_callback, void * user_data);
+    void exit();
+
+public:
+    bool set_path_weight(uint32_t path_index, uint32_t path_weight);
+    bool set_path_capacity(uint32_t path_index, double path_capacity);
+
+public:
+    bool send(const uint8_t * src_data, uint32_t src_size);
+    bool send(const PacketBatch & src_batch);
+    static void stripe_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+
+public:
+    void reset();
+
+private:
+    PacketXorStriperImpl  * m_striper;
+};
+
+class PACKET_XOR_TYPE PacketXorFanout
+{
+public:
+    PacketXorFanout();
+    PacketXorFanout(const PacketXorFanout &) = delete;
+    PacketXorFanout(PacketXorFanout &&) = delete;
+    PacketXorFanout & operator = (const PacketXorFanout &) = delete;
+    PacketXorFanout & operator = (PacketXorFanout &&) = delete;
+    ~PacketXorFanout();
+
+public:
+    bool init(uint32_t max_block_size, bool use_xor, bool use_crc = false);
+    void exit();
+
+public:
+    bool add_session(uint32_t session_id);
+    bool remove_session(uint32_t session_id);
+
+public:
+    bool encode(const uint8_t * src_data, uint32_t src_size);
+    bool emit(uint32_t session_id, std::vector<fanout_packet_t> & dst_packets);
+    bool emit(fanout_callback_t fanout_callback, void * user_data);
+
+public:
+    void reset();
+
+private:
+    PacketXorFanoutImpl   * m_fanout;
+};
+
 
 #endif // PACKET_XOR_H
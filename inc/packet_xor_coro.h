@@ -0,0 +1,457 @@
+/********************************************************
+ * Description : packet xor c++20 coroutine adapters
+ * Author      : yanrk
+ * Email       : yanrkchina@163.com
+ * Version     : 1.0
+ * History     :
+ * Copyright(C): 2021-2022
+ ********************************************************/
+
+#ifndef PACKET_XOR_CORO_H
+#define PACKET_XOR_CORO_H
+
+
+#include "packet_xor.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <chrono>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <coroutine>
+
+typedef void (*resume_callback_t)(void * user_data, std::coroutine_handle<> handle);
+typedef bool (*transmit_callback_t)(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+
+class PacketXorFrame
+{
+public:
+    PacketXorFrame() noexcept
+        : m_unifier(nullptr)
+        , m_data()
+    {
+
+    }
+
+    PacketXorFrame(PacketXorUnifier * unifier, std::vector<uint8_t> && data) noexcept
+        : m_unifier(unifier)
+        , m_data(std::move(data))
+    {
+
+    }
+
+    PacketXorFrame(const PacketXorFrame &) = delete;
+    PacketXorFrame & operator = (const PacketXorFrame &) = delete;
+
+    PacketXorFrame(PacketXorFrame && other) noexcept
+        : m_unifier(std::exchange(other.m_unifier, nullptr))
+        , m_data(std::move(other.m_data))
+    {
+
+    }
+
+    PacketXorFrame & operator = (PacketXorFrame && other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_unifier = std::exchange(other.m_unifier, nullptr);
+            m_data = std::move(other.m_data);
+        }
+        return *this;
+    }
+
+    ~PacketXorFrame()
+    {
+        release();
+    }
+
+public:
+    const uint8_t * data() const
+    {
+        return m_data.data();
+    }
+
+    uint32_t size() const
+    {
+        return static_cast<uint32_t>(m_data.size());
+    }
+
+    bool empty() const
+    {
+        return m_data.empty();
+    }
+
+    explicit operator bool () const
+    {
+        return !m_data.empty();
+    }
+
+    std::vector<uint8_t> detach()
+    {
+        m_unifier = nullptr;
+        return std::move(m_data);
+    }
+
+private:
+    void release()
+    {
+        if (nullptr != m_unifier)
+        {
+            m_unifier->recycle(std::move(m_data));
+            m_unifier = nullptr;
+        }
+        m_data.clear();
+    }
+
+private:
+    PacketXorUnifier      * m_unifier;
+    std::vector<uint8_t>    m_data;
+};
+
+class PacketXorCoroUnifier
+{
+public:
+    class frame_awaiter
+    {
+    public:
+        explicit frame_awaiter(PacketXorCoroUnifier & owner)
+            : m_owner(owner)
+            , m_handle()
+            , m_frame()
+        {
+
+        }
+
+        bool await_ready()
+        {
+            return m_owner.take_frame(m_frame);
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_owner.m_waiters.push_back(this);
+        }
+
+        PacketXorFrame await_resume()
+        {
+            return std::move(m_frame);
+        }
+
+    private:
+        friend class PacketXorCoroUnifier;
+
+        PacketXorCoroUnifier      & m_owner;
+        std::coroutine_handle<>     m_handle;
+        PacketXorFrame              m_frame;
+    };
+
+public:
+    explicit PacketXorCoroUnifier(PacketXorUnifier & unifier, resume_callback_t resume_callback = nullptr, void * user_data = nullptr)
+        : m_unifier(unifier)
+        , m_resume_callback(resume_callback)
+        , m_user_data(user_data)
+        , m_ready_frames()
+        , m_waiters()
+        , m_closed(false)
+    {
+
+    }
+
+    PacketXorCoroUnifier(const PacketXorCoroUnifier &) = delete;
+    PacketXorCoroUnifier & operator = (const PacketXorCoroUnifier &) = delete;
+
+public:
+    frame_awaiter next_frame()
+    {
+        return frame_awaiter(*this);
+    }
+
+    bool feed(const uint8_t * src_data, uint32_t src_size)
+    {
+        const bool decoded = m_unifier.decode(src_data, src_size, m_ready_frames);
+        wake_waiters();
+        return decoded;
+    }
+
+    bool poll(uint64_t now_microsecond = 0)
+    {
+        const bool decoded = m_unifier.poll(now_microsecond, m_ready_frames);
+        wake_waiters();
+        return decoded;
+    }
+
+    uint64_t next_deadline() const
+    {
+        return m_unifier.next_deadline();
+    }
+
+    void close()
+    {
+        m_closed = true;
+        wake_waiters();
+    }
+
+    std::size_t ready_count() const
+    {
+        return m_ready_frames.size();
+    }
+
+private:
+    bool take_frame(PacketXorFrame & frame)
+    {
+        if (m_ready_frames.empty())
+        {
+            return m_closed;
+        }
+        frame = PacketXorFrame(&m_unifier, std::move(m_ready_frames.front()));
+        m_ready_frames.pop_front();
+        return true;
+    }
+
+    void wake_waiters()
+    {
+        while (!m_waiters.empty() && (m_closed || !m_ready_frames.empty()))
+        {
+            frame_awaiter * waiter = m_waiters.front();
+            m_waiters.pop_front();
+            take_frame(waiter->m_frame);
+            if (nullptr != m_resume_callback)
+            {
+                (*m_resume_callback)(m_user_data, waiter->m_handle);
+            }
+            else
+            {
+                waiter->m_handle.resume();
+            }
+        }
+    }
+
+private:
+    PacketXorUnifier                  & m_unifier;
+    resume_callback_t                   m_resume_callback;
+    void                              * m_user_data;
+    std::list<std::vector<uint8_t>>     m_ready_frames;
+    std::deque<frame_awaiter *>         m_waiters;
+    bool                                m_closed;
+};
+
+class PacketXorCoroDivider
+{
+public:
+    class send_awaiter
+    {
+    public:
+        send_awaiter(PacketXorCoroDivider & owner, bool encoded)
+            : m_owner(owner)
+            , m_handle()
+            , m_encoded(encoded)
+        {
+
+        }
+
+        bool await_ready() const
+        {
+            return !m_encoded || !m_owner.congested();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_owner.m_waiters.push_back(this);
+        }
+
+        bool await_resume() const
+        {
+            return m_encoded;
+        }
+
+    private:
+        friend class PacketXorCoroDivider;
+
+        PacketXorCoroDivider      & m_owner;
+        std::coroutine_handle<>     m_handle;
+        bool                        m_encoded;
+    };
+
+public:
+    PacketXorCoroDivider(PacketXorDivider & divider, transmit_callback_t transmit_callback, void * transmit_user_data, uint64_t max_queue_bytes = 1024 * 1024, resume_callback_t resume_callback = nullptr, void * resume_user_data = nullptr)
+        : m_divider(divider)
+        , m_transmit_callback(transmit_callback)
+        , m_transmit_user_data(transmit_user_data)
+        , m_resume_callback(resume_callback)
+        , m_resume_user_data(resume_user_data)
+        , m_max_queue_bytes(max_queue_bytes)
+        , m_queue_bytes(0)
+        , m_queue()
+        , m_free_blocks()
+        , m_waiters()
+        , m_pacing_bytes_per_second(0)
+        , m_pacing_burst_bytes(0)
+        , m_pacing_tokens(0.0)
+        , m_pacing_time(std::chrono::steady_clock::now())
+    {
+
+    }
+
+    PacketXorCoroDivider(const PacketXorCoroDivider &) = delete;
+    PacketXorCoroDivider & operator = (const PacketXorCoroDivider &) = delete;
+
+public:
+    void set_pacing(uint64_t bytes_per_second, uint64_t burst_bytes)
+    {
+        m_pacing_bytes_per_second = bytes_per_second;
+        m_pacing_burst_bytes = burst_bytes;
+        m_pacing_tokens = static_cast<double>(burst_bytes);
+        m_pacing_time = std::chrono::steady_clock::now();
+    }
+
+    send_awaiter send(const uint8_t * src_data, uint32_t src_size)
+    {
+        return send_awaiter(*this, m_divider.encode(src_data, src_size, &PacketXorCoroDivider::enqueue_block, this));
+    }
+
+    send_awaiter send(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class)
+    {
+        return send_awaiter(*this, m_divider.encode(src_data, src_size, frame_class, &PacketXorCoroDivider::enqueue_block, this));
+    }
+
+    send_awaiter send(const PacketXorFrame & frame)
+    {
+        return send(frame.data(), frame.size());
+    }
+
+    uint32_t flush()
+    {
+        refill_tokens();
+        while (!m_queue.empty())
+        {
+            std::vector<uint8_t> & block = m_queue.front();
+            if (!pacing_allows(block.size()) || !(*m_transmit_callback)(m_transmit_user_data, block.data(), static_cast<uint32_t>(block.size())))
+            {
+                break;
+            }
+            consume_tokens(block.size());
+            m_queue_bytes -= block.size();
+            if (m_free_blocks.size() < 64)
+            {
+                m_free_blocks.emplace_back(std::move(block));
+            }
+            m_queue.pop_front();
+        }
+        wake_waiters();
+        return pacing_delay_microseconds();
+    }
+
+    uint64_t queue_bytes() const
+    {
+        return m_queue_bytes;
+    }
+
+private:
+    static void enqueue_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+    {
+        PacketXorCoroDivider * owner = reinterpret_cast<PacketXorCoroDivider *>(user_data);
+        if (owner->m_queue.empty())
+        {
+            owner->refill_tokens();
+            if (owner->pacing_allows(dst_size) && (*owner->m_transmit_callback)(owner->m_transmit_user_data, dst_data, dst_size))
+            {
+                owner->consume_tokens(dst_size);
+                return;
+            }
+        }
+
+        if (owner->m_free_blocks.empty())
+        {
+            owner->m_queue.emplace_back(dst_data, dst_data + dst_size);
+        }
+        else
+        {
+            owner->m_queue.emplace_back(std::move(owner->m_free_blocks.back()));
+            owner->m_free_blocks.pop_back();
+            owner->m_queue.back().assign(dst_data, dst_data + dst_size);
+        }
+        owner->m_queue_bytes += dst_size;
+    }
+
+    bool congested() const
+    {
+        return m_queue_bytes > m_max_queue_bytes;
+    }
+
+    void refill_tokens()
+    {
+        if (0 == m_pacing_bytes_per_second)
+        {
+            return;
+        }
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double elapsed_seconds = std::chrono::duration<double>(now - m_pacing_time).count();
+        m_pacing_time = now;
+        m_pacing_tokens = std::min<double>(m_pacing_tokens + elapsed_seconds * m_pacing_bytes_per_second, static_cast<double>(m_pacing_burst_bytes));
+    }
+
+    bool pacing_allows(std::size_t block_bytes) const
+    {
+        return 0 == m_pacing_bytes_per_second || m_pacing_tokens >= static_cast<double>(std::min<uint64_t>(block_bytes, m_pacing_burst_bytes));
+    }
+
+    void consume_tokens(std::size_t block_bytes)
+    {
+        if (0 != m_pacing_bytes_per_second)
+        {
+            m_pacing_tokens -= static_cast<double>(block_bytes);
+        }
+    }
+
+    uint32_t pacing_delay_microseconds() const
+    {
+        if (m_queue.empty() || 0 == m_pacing_bytes_per_second || pacing_allows(m_queue.front().size()))
+        {
+            return 0;
+        }
+        const double missing_tokens = static_cast<double>(std::min<uint64_t>(m_queue.front().size(), m_pacing_burst_bytes)) - m_pacing_tokens;
+        return static_cast<uint32_t>(missing_tokens * 1000000.0 / m_pacing_bytes_per_second) + 1;
+    }
+
+    void wake_waiters()
+    {
+        while (!m_waiters.empty() && !congested())
+        {
+            send_awaiter * waiter = m_waiters.front();
+            m_waiters.pop_front();
+            if (nullptr != m_resume_callback)
+            {
+                (*m_resume_callback)(m_resume_user_data, waiter->m_handle);
+            }
+            else
+            {
+                waiter->m_handle.resume();
+            }
+        }
+    }
+
+private:
+    PacketXorDivider                  & m_divider;
+    transmit_callback_t                 m_transmit_callback;
+    void                              * m_transmit_user_data;
+    resume_callback_t                   m_resume_callback;
+    void                              * m_resume_user_data;
+    uint64_t                            m_max_queue_bytes;
+    uint64_t                            m_queue_bytes;
+    std::deque<std::vector<uint8_t>>    m_queue;
+    std::vector<std::vector<uint8_t>>   m_free_blocks;
+    std::deque<send_awaiter *>          m_waiters;
+    uint64_t                            m_pacing_bytes_per_second;
+    uint64_t                            m_pacing_burst_bytes;
+    double                              m_pacing_tokens;
+    std::chrono::steady_clock::time_point m_pacing_time;
+};
+
+#endif // __cpp_impl_coroutine
+
+
+#endif // PACKET_XOR_CORO_H
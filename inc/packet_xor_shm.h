@@ -0,0 +1,90 @@
+/********************************************************
+ * Description : packet xor shared memory frame ring
+ * Author      : yanrk
+ * Email       : yanrkchina@163.com
+ * Version     : 1.0
+ * History     :
+ * Copyright(C): 2021-2022
+ ********************************************************/
+
+#ifndef PACKET_XOR_SHM_H
+#define PACKET_XOR_SHM_H
+
+
+#include "packet_xor.h"
+
+class PacketXorShmWriterImpl;
+class PacketXorShmReaderImpl;
+
+struct shm_stats_t
+{
+    uint64_t                published_frames;
+    uint64_t                published_bytes;
+    uint64_t                dropped_frames;
+    uint64_t                oversize_frames;
+    uint64_t                wakeups;
+};
+
+struct shm_frame_t
+{
+    const uint8_t         * data;
+    uint32_t                size;
+    uint64_t                sequence;
+};
+
+class PACKET_XOR_TYPE PacketXorShmWriter
+{
+public:
+    PacketXorShmWriter();
+    PacketXorShmWriter(const PacketXorShmWriter &) = delete;
+    PacketXorShmWriter(PacketXorShmWriter &&) = delete;
+    PacketXorShmWriter & operator = (const PacketXorShmWriter &) = delete;
+    PacketXorShmWriter & operator = (PacketXorShmWriter &&) = delete;
+    ~PacketXorShmWriter();
+
+public:
+    static bool supported();
+
+public:
+    bool init(PacketXorUnifier * unifier, uint32_t slot_count, uint32_t slot_size);
+    void exit();
+
+public:
+    int memory_fd() const;
+    int event_fd() const;
+
+public:
+    bool decode(const uint8_t * src_data, uint32_t src_size);
+
+public:
+    void get_stats(shm_stats_t & stats) const;
+
+private:
+    PacketXorShmWriterImpl    * m_writer;
+};
+
+class PACKET_XOR_TYPE PacketXorShmReader
+{
+public:
+    PacketXorShmReader();
+    PacketXorShmReader(const PacketXorShmReader &) = delete;
+    PacketXorShmReader(PacketXorShmReader &&) = delete;
+    PacketXorShmReader & operator = (const PacketXorShmReader &) = delete;
+    PacketXorShmReader & operator = (PacketXorShmReader &&) = delete;
+    ~PacketXorShmReader();
+
+public:
+    bool init(int memory_fd, int event_fd);
+    void exit();
+
+public:
+    bool acquire(shm_frame_t & frame);
+    bool release();
+    bool wait(uint32_t wait_millisecond);
+
+private:
+    PacketXorShmReaderImpl    * m_reader;
+};
+
+
+#endif // PACKET_XOR_SHM_H
@@ -0,0 +1,62 @@
+/********************************************************
+ * Description : packet xor io_uring udp engine
+ * Author      : yanrk
+ * Email       : yanrkchina@163.com
+ * Version     : 1.0
+ * History     :
+ * Copyright(C): 2021-2022
+ ********************************************************/
+
+#ifndef PACKET_XOR_URING_H
+#define PACKET_XOR_URING_H
+
+
+#include "packet_xor.h"
+
+class PacketXorUringImpl;
+
+struct uring_stats_t
+{
+    uint64_t                send_blocks;
+    uint64_t                send_errors;
+    uint64_t                recv_blocks;
+    uint64_t                recv_dropped;
+    uint64_t                recv_rearms;
+    uint64_t                zero_copy_sends;
+};
+
+class PACKET_XOR_TYPE PacketXorUring
+{
+public:
+    PacketXorUring();
+    PacketXorUring(const PacketXorUring &) = delete;
+    PacketXorUring(PacketXorUring &&) = delete;
+    PacketXorUring & operator = (const PacketXorUring &) = delete;
+    PacketXorUring & operator = (PacketXorUring &&) = delete;
+    ~PacketXorUring();
+
+public:
+    static bool supported();
+
+public:
+    bool init(const char * local_host, uint16_t local_port, PacketXorDivider * divider, PacketXorUnifier * unifier, decode_callback_t decode_callback, void * user_data, uint32_t queue_depth = 256, uint32_t buffer_count = 256, uint32_t buffer_size = 2048, bool zero_copy = true);
+    void exit();
+
+public:
+    uint16_t local_port() const;
+    bool set_peer(const char * peer_host, uint16_t peer_port);
+
+public:
+    bool send(const uint8_t * src_data, uint32_t src_size);
+    bool send(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class);
+    int run(uint32_t wait_millisecond);
+
+public:
+    void get_stats(uring_stats_t & stats) const;
+
+private:
+    PacketXorUringImpl    * m_uring;
+};
+
+
+#endif // PACKET_XOR_URING_H
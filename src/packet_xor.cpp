@@ -9,45 +9,167 @@
 
 #ifdef _MSC_VER
     #include <windows.h>
+    #include <io.h>
 #else
     #include <sys/time.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <errno.h>
 #endif // _MSC_VER
 
 #include <ctime>
+#include <cmath>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <chrono>
 #include <map>
 #include <list>
+#include <iterator>
+#include <memory>
 #include <vector>
 #include <algorithm>
 
+#if defined(__x86_64__) || defined(_M_X64)
+    #define PACKET_XOR_CRC32C_SSE42
+    #include <nmmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif // _MSC_VER
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #define PACKET_XOR_CRC32C_ARMV8
+    #include <arm_acle.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define PACKET_XOR_CLASSIFY_SSE2
+    #include <emmintrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define PACKET_XOR_BIG_ENDIAN
+#endif
+
+#ifdef _MSC_VER
+    #define PACKET_XOR_BSWAP16(value)   _byteswap_ushort(value)
+    #define PACKET_XOR_BSWAP32(value)   _byteswap_ulong(value)
+    #define PACKET_XOR_BSWAP64(value)   _byteswap_uint64(value)
+#else
+    #define PACKET_XOR_BSWAP16(value)   __builtin_bswap16(value)
+    #define PACKET_XOR_BSWAP32(value)   __builtin_bswap32(value)
+    #define PACKET_XOR_BSWAP64(value)   __builtin_bswap64(value)
+#endif // _MSC_VER
+
+#if defined(PACKET_XOR_USDT) && !defined(_MSC_VER)
+    #include <sys/sdt.h>
+    #define PACKET_XOR_PROBE2(name, a1, a2)                 DTRACE_PROBE2(packet_xor, name, a1, a2)
+    #define PACKET_XOR_PROBE4(name, a1, a2, a3, a4)         DTRACE_PROBE4(packet_xor, name, a1, a2, a3, a4)
+    #define PACKET_XOR_PROBE5(name, a1, a2, a3, a4, a5)     DTRACE_PROBE5(packet_xor, name, a1, a2, a3, a4, a5)
+#else
+    #define PACKET_XOR_PROBE2(name, a1, a2)
+    #define PACKET_XOR_PROBE4(name, a1, a2, a3, a4)
+    #define PACKET_XOR_PROBE5(name, a1, a2, a3, a4, a5)
+#endif // PACKET_XOR_USDT
+
 #include "packet_xor.h"
 
 const uint8_t s_protocol_seq = 0xe9;
 const uint8_t s_protocol_xor = 0xea;
+const uint8_t s_protocol_ext = 0x10;
+const uint8_t s_protocol_nack = 0xeb;
+const uint8_t s_protocol_parity = 0xec;
+const uint8_t s_protocol_path = 0xed;
+const uint8_t s_protocol_stream = 0xee;
+const uint8_t s_protocol_repair = 0xef;
+
+const uint8_t s_ext_flag_crc32c = 0x01;
+const uint8_t s_ext_flag_aggregate = 0x02;
+const uint8_t s_ext_flag_frame_class = 0x04;
+const uint8_t s_ext_flag_object = 0x08;
+
+const uint8_t s_reject_malformed = 1;
+const uint8_t s_reject_checksum = 2;
+const uint8_t s_reject_stale = 3;
+const uint8_t s_reject_budget = 4;
+const uint8_t s_reject_mismatch = 5;
+const uint8_t s_reject_duplicate = 6;
+
+const uint32_t s_max_frame_class = 8;
+
+const uint32_t s_max_path_count = 8;
+
+const uint32_t s_aggregate_record_head_bytes = 2;
+
+const uint32_t s_max_object_window_bytes = 64 * 1024 * 1024;
+
+const uint32_t s_max_nack_bytes = 1024;
+
+const uint32_t s_max_parity_window = 32;
+const std::size_t s_parity_history_slots = 64;
+const std::size_t s_max_pending_parities = 8;
+
+const uint32_t s_max_stream_window = 64;
+const uint64_t s_stream_history_symbols = 256;
+const uint32_t s_stream_symbol_head_bytes = 2;
+
+const uint32_t s_trace_magic = 0x50585452;
+const uint16_t s_trace_version = 1;
+const uint16_t s_trace_flag_payload = 0x0001;
+const std::size_t s_trace_buffer_bytes = 256 * 1024;
+const uint32_t s_max_trace_datagram_bytes = 16 * 1024 * 1024;
+
+const uint32_t s_group_chunk_bytes = 16 * 1024;
+const std::size_t s_max_free_chunks = 64;
+const std::size_t s_max_free_frames = 16;
 
 static void byte_order_convert(void * obj, size_t size)
 {
     assert(nullptr != obj);
 
-    static union
+#ifndef PACKET_XOR_BIG_ENDIAN
+    switch (size)
     {
-        unsigned short us;
-        unsigned char  uc[sizeof(unsigned short)];
-    } un;
-    un.us = 0x0001;
-
-    if (0x01 == un.uc[0])
-    {
-        unsigned char * bytes = static_cast<unsigned char *>(obj);
-        for (size_t i = 0; i < size / 2; ++i)
+        case 2:
+        {
+            uint16_t value = 0;
+            memcpy(&value, obj, sizeof(value));
+            value = PACKET_XOR_BSWAP16(value);
+            memcpy(obj, &value, sizeof(value));
+            break;
+        }
+        case 4:
+        {
+            uint32_t value = 0;
+            memcpy(&value, obj, sizeof(value));
+            value = PACKET_XOR_BSWAP32(value);
+            memcpy(obj, &value, sizeof(value));
+            break;
+        }
+        case 8:
         {
-            unsigned char temp = bytes[i];
-            bytes[i] = bytes[size - 1 - i];
-            bytes[size - 1 - i] = temp;
+            uint64_t value = 0;
+            memcpy(&value, obj, sizeof(value));
+            value = PACKET_XOR_BSWAP64(value);
+            memcpy(obj, &value, sizeof(value));
+            break;
+        }
+        default:
+        {
+            unsigned char * bytes = static_cast<unsigned char *>(obj);
+            for (size_t i = 0; i < size / 2; ++i)
+            {
+                unsigned char temp = bytes[i];
+                bytes[i] = bytes[size - 1 - i];
+                bytes[size - 1 - i] = temp;
+            }
+            break;
         }
     }
+#endif // PACKET_XOR_BIG_ENDIAN
 }
 
 static void host_to_net(void * obj, size_t size)
@@ -98,6 +220,193 @@ struct block_t
     }
 };
 
+struct block_ext_t
+{
+    uint8_t                             ext_flags;
+    uint8_t                             frame_class;
+    uint16_t                            deadline_millisecond;
+    uint32_t                            checksum;
+
+    void encode()
+    {
+        host_to_net(&deadline_millisecond, sizeof(deadline_millisecond));
+        host_to_net(&checksum, sizeof(checksum));
+    }
+
+    void decode()
+    {
+        net_to_host(&deadline_millisecond, sizeof(deadline_millisecond));
+        net_to_host(&checksum, sizeof(checksum));
+    }
+};
+
+struct nack_t
+{
+    uint64_t                            group_index;
+    uint8_t                             protocol_id;
+    uint8_t                             reserved;
+    uint16_t                            range_count;
+    uint32_t                            block_count;
+
+    void encode()
+    {
+        host_to_net(&group_index, sizeof(group_index));
+        host_to_net(&range_count, sizeof(range_count));
+        host_to_net(&block_count, sizeof(block_count));
+    }
+
+    void decode()
+    {
+        net_to_host(&group_index, sizeof(group_index));
+        net_to_host(&range_count, sizeof(range_count));
+        net_to_host(&block_count, sizeof(block_count));
+    }
+};
+
+struct nack_range_t
+{
+    uint32_t                            block_index;
+    uint32_t                            block_count;
+
+    void encode()
+    {
+        host_to_net(&block_index, sizeof(block_index));
+        host_to_net(&block_count, sizeof(block_count));
+    }
+
+    void decode()
+    {
+        net_to_host(&block_index, sizeof(block_index));
+        net_to_host(&block_count, sizeof(block_count));
+    }
+};
+
+struct path_head_t
+{
+    uint64_t                            path_sequence;
+    uint8_t                             protocol_id;
+    uint8_t                             path_index;
+    uint16_t                            reserved;
+    uint32_t                            send_time;
+
+    void encode()
+    {
+        host_to_net(&path_sequence, sizeof(path_sequence));
+        host_to_net(&send_time, sizeof(send_time));
+    }
+
+    void decode()
+    {
+        net_to_host(&path_sequence, sizeof(path_sequence));
+        net_to_host(&send_time, sizeof(send_time));
+    }
+};
+
+struct stream_head_t
+{
+    uint64_t                            source_sequence;
+    uint8_t                             protocol_id;
+    uint8_t                             reserved_h;
+    uint16_t                            reserved_l;
+
+    void encode()
+    {
+        host_to_net(&source_sequence, sizeof(source_sequence));
+    }
+
+    void decode()
+    {
+        net_to_host(&source_sequence, sizeof(source_sequence));
+    }
+};
+
+struct stream_repair_t
+{
+    uint64_t                            window_end;
+    uint8_t                             protocol_id;
+    uint8_t                             window_size;
+    uint16_t                            repair_bytes;
+    uint64_t                            coefficient_mask;
+
+    void encode()
+    {
+        host_to_net(&window_end, sizeof(window_end));
+        host_to_net(&repair_bytes, sizeof(repair_bytes));
+        host_to_net(&coefficient_mask, sizeof(coefficient_mask));
+    }
+
+    void decode()
+    {
+        net_to_host(&window_end, sizeof(window_end));
+        net_to_host(&repair_bytes, sizeof(repair_bytes));
+        net_to_host(&coefficient_mask, sizeof(coefficient_mask));
+    }
+};
+
+struct object_head_t
+{
+    uint32_t                            object_id;
+    uint32_t                            reserved;
+    uint64_t                            object_offset;
+    uint64_t                            object_bytes;
+
+    void encode()
+    {
+        host_to_net(&object_id, sizeof(object_id));
+        host_to_net(&object_offset, sizeof(object_offset));
+        host_to_net(&object_bytes, sizeof(object_bytes));
+    }
+
+    void decode()
+    {
+        net_to_host(&object_id, sizeof(object_id));
+        net_to_host(&object_offset, sizeof(object_offset));
+        net_to_host(&object_bytes, sizeof(object_bytes));
+    }
+};
+
+struct trace_head_t
+{
+    uint32_t                            magic;
+    uint16_t                            version;
+    uint16_t                            flags;
+
+    void encode()
+    {
+        host_to_net(&magic, sizeof(magic));
+        host_to_net(&version, sizeof(version));
+        host_to_net(&flags, sizeof(flags));
+    }
+
+    void decode()
+    {
+        net_to_host(&magic, sizeof(magic));
+        net_to_host(&version, sizeof(version));
+        net_to_host(&flags, sizeof(flags));
+    }
+};
+
+struct trace_record_t
+{
+    uint64_t                            timestamp;
+    uint32_t                            datagram_bytes;
+    uint32_t                            captured_bytes;
+
+    void encode()
+    {
+        host_to_net(&timestamp, sizeof(timestamp));
+        host_to_net(&datagram_bytes, sizeof(datagram_bytes));
+        host_to_net(&captured_bytes, sizeof(captured_bytes));
+    }
+
+    void decode()
+    {
+        net_to_host(&timestamp, sizeof(timestamp));
+        net_to_host(&datagram_bytes, sizeof(datagram_bytes));
+        net_to_host(&captured_bytes, sizeof(captured_bytes));
+    }
+};
+
 #pragma pack(pop)
 
 struct group_head_t
@@ -106,12 +415,36 @@ struct group_head_t
     uint32_t                            group_bytes;
     uint32_t                            need_block_count;
     uint32_t                            recv_block_count;
+    uint32_t                            block_stride;
+    uint64_t                            memory_bytes;
+    uint64_t                            nack_time;
+    uint64_t                            first_time;
+    uint64_t                            last_time;
+    uint8_t                             frame_class;
+    bool                                aggregate;
+    bool                                object;
+    uint32_t                            progress_blocks;
+    uint32_t                            progress_bytes;
+    bool                                progress_done;
+    bool                                tail_arrived;
 
     group_head_t()
         : group_index(0)
         , group_bytes(0)
         , need_block_count(0)
         , recv_block_count(0)
+        , block_stride(0)
+        , memory_bytes(0)
+        , nack_time(0)
+        , first_time(0)
+        , last_time(0)
+        , frame_class(0)
+        , aggregate(false)
+        , object(false)
+        , progress_blocks(0)
+        , progress_bytes(0)
+        , progress_done(false)
+        , tail_arrived(false)
     {
 
     }
@@ -121,7 +454,21 @@ struct group_body_t
 {
     std::vector<uint8_t>                seq_block_bitmap;
     std::vector<uint8_t>                xor_block_bitmap;
-    std::vector<uint8_t>                group_data;
+    std::vector<std::unique_ptr<uint8_t[]>> group_chunks;
+    std::size_t                         chunk_count;
+    std::map<uint32_t, std::vector<uint8_t>> xor_blocks;
+    uint64_t                            xor_store_bytes;
+
+    group_body_t()
+        : seq_block_bitmap()
+        , xor_block_bitmap()
+        , group_chunks()
+        , chunk_count(0)
+        , xor_blocks()
+        , xor_store_bytes(0)
+    {
+
+    }
 };
 
 struct group_t
@@ -137,705 +484,5082 @@ struct decode_timer_t
     uint32_t                            decode_microseconds;
 };
 
-struct groups_t
+struct expire_estimator_t
 {
-    uint64_t                            min_group_index;
-    uint64_t                            new_group_index;
-    std::map<uint64_t, group_t>         group_items;
-    std::list<decode_timer_t>           decode_timer_list;
+    bool                                enabled;
+    uint32_t                            min_expire_microseconds;
+    uint32_t                            max_expire_microseconds;
+    double                              jitter_factor;
+    bool                                gap_valid;
+    double                              gap_average;
+    double                              gap_deviation;
+    bool                                spread_valid;
+    double                              spread_average;
+    double                              spread_deviation;
 
-    groups_t()
-        : min_group_index(0)
-        , new_group_index(0)
-        , group_items()
-        , decode_timer_list()
+    expire_estimator_t()
+        : enabled(false)
+        , min_expire_microseconds(0)
+        , max_expire_microseconds(0)
+        , jitter_factor(0.0)
+        , gap_valid(false)
+        , gap_average(0.0)
+        , gap_deviation(0.0)
+        , spread_valid(false)
+        , spread_average(0.0)
+        , spread_deviation(0.0)
     {
 
     }
 
     void reset()
     {
-        min_group_index = 0;
-        new_group_index = 0;
-        group_items.clear();
-        decode_timer_list.clear();
+        gap_valid = false;
+        gap_average = 0.0;
+        gap_deviation = 0.0;
+        spread_valid = false;
+        spread_average = 0.0;
+        spread_deviation = 0.0;
     }
 };
 
-static void get_current_time(uint32_t & seconds, uint32_t & microseconds)
+static void estimator_sample(bool & valid, double & average, double & deviation, double sample)
 {
-#ifdef _MSC_VER
-    SYSTEMTIME sys_now = { 0x0 };
-    GetLocalTime(&sys_now);
-    seconds = static_cast<uint32_t>(time(nullptr));
-    microseconds = static_cast<uint32_t>(sys_now.wMilliseconds * 1000);
-#else
-    struct timeval tv_now = { 0x0 };
-    gettimeofday(&tv_now, nullptr);
-    seconds = static_cast<uint32_t>(tv_now.tv_sec);
-    microseconds = static_cast<uint32_t>(tv_now.tv_usec);
-#endif // _MSC_VER
+    if (!valid)
+    {
+        valid = true;
+        average = sample;
+        deviation = sample / 2;
+    }
+    else
+    {
+        deviation += (std::fabs(sample - average) - deviation) / 4;
+        average += (sample - average) / 8;
+    }
 }
 
-static void fill_xor_data(uint8_t * xor_data, const uint8_t * prev_data, const uint8_t * next_data, uint32_t data_size)
+static uint32_t estimate_expire_microseconds(const expire_estimator_t & estimator, uint32_t block_count, uint32_t default_expire_microseconds)
 {
-    for (uint32_t index = 0; index < data_size; ++index)
+    double expire_microseconds = default_expire_microseconds;
+    if (estimator.gap_valid || estimator.spread_valid)
     {
-        xor_data[index] = prev_data[index] ^ next_data[index];
+        const double spread_gaps = (block_count > 0 ? block_count - 1 : 0);
+        const double span = spread_gaps * (estimator.spread_valid ? estimator.spread_average : estimator.gap_average);
+        const double jitter = spread_gaps * estimator.spread_deviation + estimator.gap_deviation;
+        expire_microseconds = span + estimator.jitter_factor * jitter;
     }
+    expire_microseconds = std::max<double>(expire_microseconds, estimator.min_expire_microseconds);
+    expire_microseconds = std::min<double>(expire_microseconds, estimator.max_expire_microseconds);
+    return static_cast<uint32_t>(expire_microseconds);
 }
 
-static bool packet_divide(const uint8_t * src_data, uint32_t src_size, uint32_t max_block_size, bool use_xor, uint64_t & group_index, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+struct object_output_t
 {
-    if (nullptr == src_data || 0 == src_size)
-    {
-        return false;
-    }
+    int                                 file_descriptor;
+    uint8_t                           * mapped_data;
+    uint64_t                            mapped_bytes;
+    uint32_t                            object_id;
+    object_callback_t                   object_callback;
+    void                              * user_data;
 
-    if (max_block_size <= sizeof(block_t))
+    object_output_t()
+        : file_descriptor(-1)
+        , mapped_data(nullptr)
+        , mapped_bytes(0)
+        , object_id(0)
+        , object_callback(nullptr)
+        , user_data(nullptr)
     {
-        return false;
+
     }
+};
 
-    uint32_t max_block_bytes = static_cast<uint32_t>(max_block_size - sizeof(block_t));
-    uint32_t group_bytes = src_size;
-    uint32_t block_pos = 0;
-    uint32_t block_index = 0;
-    uint32_t block_count = (group_bytes + max_block_bytes - 1) / max_block_bytes;
-    if (block_count > 0x00FFFFFF)
+struct trace_output_t
+{
+    std::FILE                         * file;
+    bool                                with_payload;
+    std::vector<uint8_t>                buffer;
+
+    trace_output_t()
+        : file(nullptr)
+        , with_payload(false)
+        , buffer()
     {
-        return false;
+
     }
+};
 
-    std::vector<uint8_t> * pre_buffer_ptr = nullptr;
-    block_t xor_block = { 0x0 };
+struct parity_slot_t
+{
+    uint64_t                            group_index;
+    std::vector<uint8_t>                block_data;
 
-    while (0 != src_size)
+    parity_slot_t()
+        : group_index(0)
+        , block_data()
     {
-        uint32_t block_bytes = std::min<uint32_t>(max_block_bytes, src_size);
 
-        block_t seq_block = { 0x0 };
-        seq_block.group_index = group_index;
-        seq_block.group_bytes = group_bytes;
-        seq_block.block_pos = block_pos;
-        seq_block.protocol_id = s_protocol_seq;
-        seq_block.block_idx_h = static_cast<uint8_t>((block_index >> 16) & 0x00FF);
-        seq_block.block_idx_l = static_cast<uint16_t>(block_index & 0xFFFF);
-        seq_block.block_count = block_count;
-        seq_block.block_bytes = block_bytes;
+    }
+};
 
-        xor_block = seq_block;
-        xor_block.protocol_id = s_protocol_xor;
+struct cross_parity_t
+{
+    bool                                active;
+    uint64_t                            gap_group_index;
+    uint64_t                            gap_time;
+    uint64_t                            gap_deadline;
+    std::vector<parity_slot_t>          history;
+    std::list<std::vector<uint8_t>>     pending;
+    uint64_t                            recovered_groups;
 
-        seq_block.encode();
-        xor_block.encode();
+    cross_parity_t()
+        : active(false)
+        , gap_group_index(0)
+        , gap_time(0)
+        , gap_deadline(0)
+        , history(s_parity_history_slots)
+        , pending()
+        , recovered_groups(0)
+    {
 
-        std::vector<uint8_t> seq_buffer(static_cast<uint32_t>(sizeof(seq_block) + max_block_bytes), 0x0);
-        memcpy(&seq_buffer[0], &seq_block, sizeof(seq_block));
-        memcpy(&seq_buffer[sizeof(seq_block)], src_data, block_bytes);
+    }
 
-        if (use_xor)
-        {
-            if (1 == block_count)
-            {
-                if (nullptr != encode_callback)
-                {
-                    (*encode_callback)(user_data, &seq_buffer[0], static_cast<uint32_t>(seq_buffer.size()));
-                }
-                dst_list.push_back(seq_buffer);
-                if (nullptr != encode_callback)
-                {
-                    (*encode_callback)(user_data, &seq_buffer[0], static_cast<uint32_t>(seq_buffer.size()));
-                }
-                dst_list.emplace_back(std::move(seq_buffer));
-            }
-            else if (0 == block_index)
-            {
-                if (nullptr != encode_callback)
-                {
-                    (*encode_callback)(user_data, &seq_buffer[0], static_cast<uint32_t>(seq_buffer.size()));
-                }
-                dst_list.emplace_back(std::move(seq_buffer));
-                pre_buffer_ptr = &dst_list.back();
-            }
-            else
-            {
-                std::vector<uint8_t> & pre_buffer = *pre_buffer_ptr;
-                std::vector<uint8_t> xor_buffer(static_cast<uint32_t>(sizeof(xor_block) + max_block_bytes), 0x0);
-                memcpy(&xor_buffer[0], &xor_block, sizeof(xor_block));
-                fill_xor_data(&xor_buffer[sizeof(xor_block)], &pre_buffer[sizeof(seq_block)], &seq_buffer[sizeof(seq_block)], max_block_bytes);
-                if (nullptr != encode_callback)
-                {
-                    (*encode_callback)(user_data, &seq_buffer[0], static_cast<uint32_t>(seq_buffer.size()));
-                }
-                dst_list.emplace_back(std::move(seq_buffer));
-                pre_buffer_ptr = &dst_list.back();
-                if (nullptr != encode_callback)
-                {
-                    (*encode_callback)(user_data, &xor_buffer[0], static_cast<uint32_t>(xor_buffer.size()));
-                }
-                dst_list.emplace_back(std::move(xor_buffer));
-            }
-        }
-        else
+    void reset()
+    {
+        active = false;
+        gap_group_index = 0;
+        gap_time = 0;
+        gap_deadline = 0;
+        for (std::vector<parity_slot_t>::iterator iter = history.begin(); history.end() != iter; ++iter)
         {
-            if (nullptr != encode_callback)
-            {
-                (*encode_callback)(user_data, &seq_buffer[0], static_cast<uint32_t>(seq_buffer.size()));
-            }
-            dst_list.emplace_back(std::move(seq_buffer));
+            iter->block_data.clear();
         }
+        pending.clear();
+        recovered_groups = 0;
+    }
+};
 
-        src_data += block_bytes;
-        src_size -= block_bytes;
-        block_pos += block_bytes;
+struct path_state_t
+{
+    bool                                active;
+    uint64_t                            first_sequence;
+    uint64_t                            max_sequence;
+    uint64_t                            received_blocks;
+    uint64_t                            received_bytes;
+    bool                                delay_valid;
+    double                              delay_average;
+    double                              delay_deviation;
 
-        ++block_index;
-    }
+    path_state_t()
+        : active(false)
+        , first_sequence(0)
+        , max_sequence(0)
+        , received_blocks(0)
+        , received_bytes(0)
+        , delay_valid(false)
+        , delay_average(0.0)
+        , delay_deviation(0.0)
+    {
 
-    ++group_index;
+    }
+};
 
-    return true;
-}
+struct stream_equation_t
+{
+    std::vector<uint64_t>               unknowns;
+    std::vector<uint8_t>                payload;
+};
 
-static bool insert_group_block(group_t & group, block_t & cur_block, uint32_t cur_block_index, const uint8_t * data, uint32_t size)
+struct stream_decoder_t
 {
-    group_head_t & group_head = group.head;
-    group_body_t & group_body = group.body;
-    uint32_t pre_block_index = cur_block_index - 1;
-    uint32_t nex_block_index = cur_block_index + 1;
+    uint64_t                            max_sequence;
+    std::map<uint64_t, std::vector<uint8_t>> symbols;
+    std::map<uint64_t, stream_equation_t> equations;
+    uint64_t                            recovered_blocks;
 
-    if (s_protocol_seq == cur_block.protocol_id)
+    stream_decoder_t()
+        : max_sequence(0)
+        , symbols()
+        , equations()
+        , recovered_blocks(0)
     {
-        if (group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+
+    }
+
+    void reset()
+    {
+        max_sequence = 0;
+        symbols.clear();
+        equations.clear();
+        recovered_blocks = 0;
+    }
+};
+
+struct groups_t
+{
+    uint64_t                            min_group_index;
+    uint64_t                            new_group_index;
+    std::map<uint64_t, group_t>         group_items;
+    std::list<decode_timer_t>           decode_timer_list;
+    uint64_t                            checksum_error_blocks;
+    uint64_t                            memory_budget_bytes;
+    uint32_t                            max_group_bytes;
+    uint64_t                            memory_used_bytes;
+    uint64_t                            memory_peak_bytes;
+    uint64_t                            rejected_groups;
+    uint64_t                            evicted_groups;
+    std::vector<std::unique_ptr<uint8_t[]>> free_chunks;
+    std::vector<uint8_t>                frame_buffer;
+    std::vector<std::vector<uint8_t>>   free_frames;
+    uint32_t                            nack_delay_microseconds;
+    nack_callback_t                     nack_callback;
+    void                              * nack_user_data;
+    uint64_t                            next_nack_time;
+    uint64_t                            nack_messages;
+    uint64_t                            nack_blocks;
+    expire_estimator_t                  expire_estimator;
+    object_output_t                     object_output;
+    uint64_t                            object_windows;
+    uint64_t                            object_dropped_windows;
+    progress_callback_t                 progress_callback;
+    complete_callback_t                 complete_callback;
+    void                              * progress_user_data;
+    cross_parity_t                      cross_parity;
+    uint64_t                            current_time;
+    bool                                replaying;
+    bool                                skip_checksum;
+    trace_output_t                      trace_output;
+    replay_stats_t                    * replay_stats;
+    std::vector<path_state_t>           path_states;
+    bool                                path_clock_valid;
+    uint32_t                            path_clock_offset;
+    bool                                lazy_recovery;
+    uint32_t                            lazy_margin_microseconds;
+    uint64_t                            xor_processed_bytes;
+    stream_decoder_t                    stream_decoder;
+    const uint8_t                     * hint_data;
+    const block_view_t                * hint_view;
+
+    groups_t(uint64_t memory_budget = 0, uint32_t group_bytes_limit = 0)
+        : min_group_index(0)
+        , new_group_index(0)
+        , group_items()
+        , decode_timer_list()
+        , checksum_error_blocks(0)
+        , memory_budget_bytes(memory_budget)
+        , max_group_bytes(group_bytes_limit)
+        , memory_used_bytes(0)
+        , memory_peak_bytes(0)
+        , rejected_groups(0)
+        , evicted_groups(0)
+        , free_chunks()
+        , frame_buffer()
+        , free_frames()
+        , nack_delay_microseconds(0)
+        , nack_callback(nullptr)
+        , nack_user_data(nullptr)
+        , next_nack_time(0)
+        , nack_messages(0)
+        , nack_blocks(0)
+        , expire_estimator()
+        , object_output()
+        , object_windows(0)
+        , object_dropped_windows(0)
+        , progress_callback(nullptr)
+        , complete_callback(nullptr)
+        , progress_user_data(nullptr)
+        , cross_parity()
+        , current_time(0)
+        , replaying(false)
+        , skip_checksum(false)
+        , trace_output()
+        , replay_stats(nullptr)
+        , path_states(s_max_path_count)
+        , path_clock_valid(false)
+        , path_clock_offset(0)
+        , lazy_recovery(false)
+        , lazy_margin_microseconds(0)
+        , xor_processed_bytes(0)
+        , stream_decoder()
+        , hint_data(nullptr)
+        , hint_view(nullptr)
+    {
+
+    }
+
+    void reset()
+    {
+        min_group_index = 0;
+        new_group_index = 0;
+        group_items.clear();
+        decode_timer_list.clear();
+        checksum_error_blocks = 0;
+        memory_used_bytes = 0;
+        memory_peak_bytes = 0;
+        rejected_groups = 0;
+        evicted_groups = 0;
+        next_nack_time = 0;
+        nack_messages = 0;
+        nack_blocks = 0;
+        expire_estimator.reset();
+        object_windows = 0;
+        object_dropped_windows = 0;
+        cross_parity.reset();
+        path_states.assign(s_max_path_count, path_state_t());
+        path_clock_valid = false;
+        path_clock_offset = 0;
+        xor_processed_bytes = 0;
+        stream_decoder.reset();
+    }
+};
+
+struct frame_class_t
+{
+    uint32_t                            xor_stride;
+    uint16_t                            deadline_millisecond;
+};
+
+struct send_frame_t
+{
+    uint64_t                            enqueue_time;
+    uint64_t                            deadline;
+    int32_t                             frame_class;
+    std::vector<uint8_t>                frame_data;
+};
+
+struct retransmit_slot_t
+{
+    uint64_t                            group_index;
+    uint32_t                            block_index;
+    std::vector<uint8_t>                block_data;
+};
+
+struct retransmit_cache_t
+{
+    std::vector<retransmit_slot_t>      slots;
+    std::size_t                         slot_head;
+    std::size_t                         slot_count;
+
+    retransmit_cache_t()
+        : slots()
+        , slot_head(0)
+        , slot_count(0)
+    {
+
+    }
+
+    void reset()
+    {
+        slot_head = 0;
+        slot_count = 0;
+    }
+};
+
+static void cache_block(retransmit_cache_t & cache, uint64_t group_index, uint32_t block_index, const uint8_t * block_data, uint32_t block_size)
+{
+    if (cache.slots.empty())
+    {
+        return;
+    }
+
+    std::size_t slot_index = 0;
+    if (cache.slot_count < cache.slots.size())
+    {
+        slot_index = (cache.slot_head + cache.slot_count) % cache.slots.size();
+        cache.slot_count += 1;
+    }
+    else
+    {
+        slot_index = cache.slot_head;
+        cache.slot_head = (cache.slot_head + 1) % cache.slots.size();
+    }
+
+    retransmit_slot_t & slot = cache.slots[slot_index];
+    slot.group_index = group_index;
+    slot.block_index = block_index;
+    slot.block_data.assign(block_data, block_data + block_size);
+}
+
+static const retransmit_slot_t & cached_block(const retransmit_cache_t & cache, std::size_t position)
+{
+    return cache.slots[(cache.slot_head + position) % cache.slots.size()];
+}
+
+static std::size_t find_cached_block(const retransmit_cache_t & cache, uint64_t group_index, uint32_t block_index)
+{
+    std::size_t low = 0;
+    std::size_t high = cache.slot_count;
+    while (low < high)
+    {
+        const std::size_t middle = low + (high - low) / 2;
+        const retransmit_slot_t & slot = cached_block(cache, middle);
+        if (slot.group_index < group_index || (slot.group_index == group_index && slot.block_index < block_index))
         {
-            return false;
+            low = middle + 1;
         }
-
-        if (cur_block_index > 0)
+        else
         {
-            if (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
-            {
-                group_body.xor_block_bitmap[cur_block_index >> 3] &= ~static_cast<uint8_t>(1 << (cur_block_index & 7));
-                std::vector<uint8_t> pre_buffer(size, 0x0);
-                fill_xor_data(&pre_buffer[0], &group_body.group_data[cur_block.block_pos], data, size);
-                block_t pre_block = cur_block;
-                pre_block.protocol_id = s_protocol_seq;
-                pre_block.block_bytes = size;
-                pre_block.block_pos -= size;
-                insert_group_block(group, pre_block, pre_block_index, &pre_buffer[0], size);
-            }
+            high = middle;
         }
+    }
+    return low;
+}
 
-        group_head.recv_block_count += 1;
-        group_body.xor_block_bitmap[cur_block_index >> 3] &= ~static_cast<uint8_t>(1 << (cur_block_index & 7));
-        group_body.seq_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
+static uint64_t group_memory_bytes(uint32_t block_count, uint64_t chunk_slots, uint64_t chunk_count)
+{
+    return sizeof(std::map<uint64_t, group_t>::value_type) + sizeof(decode_timer_t) + 2 * ((static_cast<uint64_t>(block_count) + 7) / 8) + chunk_slots * sizeof(std::unique_ptr<uint8_t[]>) + chunk_count * s_group_chunk_bytes;
+}
 
-        if (cur_block_index + 1 == cur_block.block_count)
-        {
-            group_body.group_data.resize(std::max<std::size_t>(group_body.group_data.size(), cur_block.block_pos + size), 0x0);
-        }
-        memcpy(&group_body.group_data[cur_block.block_pos], data, size);
+static void update_group_memory(groups_t & groups, group_t & group)
+{
+    const uint64_t memory_bytes = group_memory_bytes(group.head.need_block_count, group.body.group_chunks.capacity(), group.body.chunk_count) + group.body.xor_store_bytes;
+    groups.memory_used_bytes = groups.memory_used_bytes - group.head.memory_bytes + memory_bytes;
+    groups.memory_peak_bytes = std::max<uint64_t>(groups.memory_peak_bytes, groups.memory_used_bytes);
+    group.head.memory_bytes = memory_bytes;
+}
 
-        if (nex_block_index < cur_block.block_count)
+static void remove_group(groups_t & groups, std::map<uint64_t, group_t>::iterator group_iter)
+{
+    const group_head_t & group_head = group_iter->second.head;
+    if (nullptr != groups.complete_callback && 0 != group_head.progress_bytes && !group_head.progress_done)
+    {
+        (*groups.complete_callback)(groups.progress_user_data, group_head.group_index, group_head.group_bytes, false);
+    }
+
+    std::vector<std::unique_ptr<uint8_t[]>> & group_chunks = group_iter->second.body.group_chunks;
+    for (std::vector<std::unique_ptr<uint8_t[]>>::iterator iter = group_chunks.begin(); group_chunks.end() != iter && groups.free_chunks.size() < s_max_free_chunks; ++iter)
+    {
+        if (*iter)
         {
-            if (group_body.xor_block_bitmap[nex_block_index >> 3] & (1 << (nex_block_index & 7)))
-            {
-                group_body.xor_block_bitmap[nex_block_index >> 3] &= ~static_cast<uint8_t>(1 << (nex_block_index & 7));
-                std::vector<uint8_t> nex_buffer(size, 0x0);
-                fill_xor_data(&nex_buffer[0], &group_body.group_data[cur_block.block_pos + size], data, size);
-                block_t nex_block = cur_block;
-                nex_block.protocol_id = s_protocol_seq;
-                nex_block.block_bytes = size;
-                nex_block.block_pos += size;
-                insert_group_block(group, nex_block, nex_block_index, &nex_buffer[0], size);
-            }
+            groups.free_chunks.emplace_back(std::move(*iter));
         }
     }
-    else
+
+    groups.memory_used_bytes -= group_iter->second.head.memory_bytes;
+    groups.group_items.erase(group_iter);
+}
+
+static void remove_group(groups_t & groups, uint64_t group_index)
+{
+    std::map<uint64_t, group_t>::iterator group_iter = groups.group_items.find(group_index);
+    if (groups.group_items.end() != group_iter)
     {
-        if (0 == cur_block_index)
+        remove_group(groups, group_iter);
+    }
+}
+
+static bool evict_group(groups_t & groups, uint64_t keep_group_index)
+{
+    std::map<uint64_t, group_t>::iterator victim_iter = groups.group_items.end();
+    for (std::map<uint64_t, group_t>::iterator iter = groups.group_items.begin(); groups.group_items.end() != iter; ++iter)
+    {
+        const group_head_t & group_head = iter->second.head;
+        if (0 == group_head.need_block_count || group_head.recv_block_count == group_head.need_block_count || keep_group_index == iter->first)
         {
-            return false;
+            continue;
         }
 
-        if (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        if (groups.group_items.end() == victim_iter)
         {
-            return false;
+            victim_iter = iter;
+            continue;
         }
 
-        if (group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        const group_head_t & victim_head = victim_iter->second.head;
+        if (group_head.frame_class != victim_head.frame_class)
         {
-            if (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7)))
-            {
-                return false;
-            }
-            else
+            if (group_head.frame_class < victim_head.frame_class)
             {
-                std::vector<uint8_t> pre_buffer(size, 0x0);
-                fill_xor_data(&pre_buffer[0], &group_body.group_data[cur_block.block_pos], data, size);
-                block_t pre_block = cur_block;
-                pre_block.protocol_id = s_protocol_seq;
-                pre_block.block_bytes = size;
-                pre_block.block_pos -= size;
-                insert_group_block(group, pre_block, pre_block_index, &pre_buffer[0], size);
+                victim_iter = iter;
             }
         }
-        else
+        else if (static_cast<uint64_t>(group_head.recv_block_count) * victim_head.need_block_count < static_cast<uint64_t>(victim_head.recv_block_count) * group_head.need_block_count)
         {
-            if (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7)))
-            {
-                std::vector<uint8_t> cur_buffer(size, 0x0);
-                fill_xor_data(&cur_buffer[0], &group_body.group_data[cur_block.block_pos - size], data, size);
-                cur_block.protocol_id = s_protocol_seq;
-                insert_group_block(group, cur_block, cur_block_index, &cur_buffer[0], size);
-            }
-            else
-            {
-                group_body.xor_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
-                if (cur_block_index + 1 == cur_block.block_count)
-                {
-                    group_body.group_data.resize(std::max<std::size_t>(group_body.group_data.size(), cur_block.block_pos + size), 0x0);
-                }
-                memcpy(&group_body.group_data[cur_block.block_pos], data, size);
-            }
+            victim_iter = iter;
+        }
+    }
+
+    if (groups.group_items.end() == victim_iter)
+    {
+        return false;
+    }
+
+    for (std::list<decode_timer_t>::iterator iter = groups.decode_timer_list.begin(); groups.decode_timer_list.end() != iter; ++iter)
+    {
+        if (iter->group_index == victim_iter->first)
+        {
+            groups.decode_timer_list.erase(iter);
+            break;
         }
     }
 
+    remove_group(groups, victim_iter);
+    groups.evicted_groups += 1;
+
     return true;
 }
 
-static bool insert_group_block(const void * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+static uint64_t group_chunk_span(uint64_t data_pos, uint64_t data_size)
+{
+    return 0 == data_size ? 0 : (data_pos + data_size - 1) / s_group_chunk_bytes - data_pos / s_group_chunk_bytes + 1;
+}
+
+static bool admit_group(groups_t & groups, uint64_t group_index, uint32_t block_count, uint32_t group_bytes, uint64_t data_pos, uint64_t data_size)
 {
-    if (size < sizeof(block_t))
+    if (0 != groups.max_group_bytes && group_bytes > groups.max_group_bytes)
     {
+        groups.rejected_groups += 1;
         return false;
     }
 
-    block_t block = *reinterpret_cast<const block_t *>(data);
-    block.decode();
-
-    if (s_protocol_seq != block.protocol_id)
+    if (0 == groups.memory_budget_bytes)
     {
-        if (s_protocol_xor != block.protocol_id)
-        {
-            return false;
-        }
-        else if (0 == block.block_idx_h && 0 == block.block_idx_l)
-        {
-            return false;
-        }
+        return true;
     }
 
-    uint32_t new_block_index = static_cast<uint32_t>(static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
-    if (new_block_index >= block.block_count)
+    const uint64_t memory_bytes = group_memory_bytes(block_count, (data_pos + data_size + s_group_chunk_bytes - 1) / s_group_chunk_bytes, group_chunk_span(data_pos, data_size));
+    if (memory_bytes > groups.memory_budget_bytes)
     {
+        groups.rejected_groups += 1;
         return false;
     }
-    else if (new_block_index + 1 == block.block_count)
+
+    while (groups.memory_used_bytes + memory_bytes > groups.memory_budget_bytes)
     {
-        if (sizeof(block) + block.block_bytes > size || block.block_pos + block.block_bytes < block.group_bytes)
+        if (!evict_group(groups, group_index))
         {
+            groups.rejected_groups += 1;
             return false;
         }
     }
-    else
+
+    return true;
+}
+
+static void enforce_memory_budget(groups_t & groups, uint64_t group_index)
+{
+    if (0 == groups.memory_budget_bytes)
+    {
+        return;
+    }
+
+    while (groups.memory_used_bytes > groups.memory_budget_bytes)
     {
-        if (sizeof(block) + block.block_bytes != size || block.block_pos + block.block_bytes > block.group_bytes)
+        if (!evict_group(groups, group_index))
         {
-            return false;
+            break;
         }
     }
+}
 
-    if (block.group_index < groups.min_group_index)
+static uint8_t * acquire_group_chunk(groups_t & groups, group_body_t & group_body, std::size_t chunk_index)
+{
+    if (group_body.group_chunks.size() <= chunk_index)
     {
-        return false;
+        group_body.group_chunks.resize(chunk_index + 1);
     }
 
-    groups.new_group_index = block.group_index;
-
-    group_t & group = groups.group_items[groups.new_group_index];
-    group_head_t & group_head = group.head;
-    group_body_t & group_body = group.body;
-
-    if (0 == group_head.need_block_count)
+    std::unique_ptr<uint8_t[]> & group_chunk = group_body.group_chunks[chunk_index];
+    if (!group_chunk)
     {
-        group_head.group_index = block.group_index;
-        group_head.group_bytes = block.group_bytes;
-        group_head.need_block_count = block.block_count;
-
-        group_body.seq_block_bitmap.resize((block.block_count + 7) / 8, 0x0);
-        group_body.xor_block_bitmap.resize((block.block_count + 7) / 8, 0x0);
-
-        if (s_protocol_seq == block.protocol_id)
+        if (groups.free_chunks.empty())
         {
-            group_head.recv_block_count += 1;
-            group_body.xor_block_bitmap[new_block_index >> 3] &= ~static_cast<uint8_t>(1 << (new_block_index & 7));
-            group_body.seq_block_bitmap[new_block_index >> 3] |= (1 << (new_block_index & 7));
+            group_chunk.reset(new uint8_t[s_group_chunk_bytes]);
         }
         else
         {
-            group_body.xor_block_bitmap[new_block_index >> 3] |= (1 << (new_block_index & 7));
+            group_chunk = std::move(groups.free_chunks.back());
+            groups.free_chunks.pop_back();
         }
+        group_body.chunk_count += 1;
+    }
 
-        group_body.group_data.resize(std::max<std::size_t>(block.group_bytes, block.block_pos + size - sizeof(block)), 0x0);
-        memcpy(&group_body.group_data[block.block_pos], reinterpret_cast<const uint8_t *>(data) + sizeof(block), size - sizeof(block));
+    return group_chunk.get();
+}
 
-        decode_timer_t decode_timer = { 0x0 };
-        decode_timer.group_index = block.group_index;
-        get_current_time(decode_timer.decode_seconds, decode_timer.decode_microseconds);
-        decode_timer.decode_microseconds += max_delay_microseconds * (group_head.need_block_count / 100 + 1);
-        decode_timer.decode_seconds += decode_timer.decode_microseconds / 1000000;
-        decode_timer.decode_microseconds %= 1000000;
+static uint64_t group_extent_bytes(const group_head_t & group_head)
+{
+    return static_cast<uint64_t>(group_head.need_block_count) * group_head.block_stride;
+}
 
-        groups.decode_timer_list.push_back(decode_timer);
-    }
-    else if (group_head.recv_block_count < group_head.need_block_count)
+static void write_group_data(groups_t & groups, group_t & group, uint64_t data_pos, const uint8_t * data, uint32_t size)
+{
+    group_body_t & group_body = group.body;
+    const uint64_t group_extent = group_extent_bytes(group.head);
+    if (data_pos >= group_extent)
     {
-        if (block.group_index != group_head.group_index || block.group_bytes != group_head.group_bytes || block.block_count != group_head.need_block_count)
-        {
-            return false;
-        }
-
-        return insert_group_block(group, block, new_block_index, reinterpret_cast<const uint8_t *>(data) + sizeof(block), static_cast<uint32_t>(size - sizeof(block)));
+        return;
     }
 
-    return true;
+    size = static_cast<uint32_t>(std::min<uint64_t>(size, group_extent - data_pos));
+    while (0 != size)
+    {
+        const uint32_t chunk_pos = static_cast<uint32_t>(data_pos % s_group_chunk_bytes);
+        const uint32_t copy_bytes = std::min<uint32_t>(size, s_group_chunk_bytes - chunk_pos);
+        memcpy(acquire_group_chunk(groups, group_body, static_cast<std::size_t>(data_pos / s_group_chunk_bytes)) + chunk_pos, data, copy_bytes);
+        data += copy_bytes;
+        size -= copy_bytes;
+        data_pos += copy_bytes;
+    }
 }
 
-static void remove_expired_blocks(groups_t & groups)
+static bool read_group_data(const group_t & group, uint64_t data_pos, uint8_t * data, uint32_t size)
 {
-    std::map<uint64_t, group_t> & group_items = groups.group_items;
-    for (std::map<uint64_t, group_t>::iterator iter = group_items.begin(); group_items.end() != iter; iter = group_items.erase(iter))
+    const group_body_t & group_body = group.body;
+    const uint64_t data_end = std::min<uint64_t>(data_pos + size, std::max<uint64_t>(data_pos, group_extent_bytes(group.head)));
+    memset(data + (data_end - data_pos), 0x0, static_cast<std::size_t>(data_pos + size - data_end));
+    size = static_cast<uint32_t>(data_end - data_pos);
+
+    while (0 != size)
     {
-        if (iter->first >= groups.min_group_index)
+        const uint32_t chunk_pos = static_cast<uint32_t>(data_pos % s_group_chunk_bytes);
+        const uint32_t copy_bytes = std::min<uint32_t>(size, s_group_chunk_bytes - chunk_pos);
+        const std::size_t chunk_index = static_cast<std::size_t>(data_pos / s_group_chunk_bytes);
+        if (chunk_index >= group_body.group_chunks.size() || !group_body.group_chunks[chunk_index])
         {
-            break;
+            memset(data, 0x0, size);
+            return false;
         }
+        memcpy(data, group_body.group_chunks[chunk_index].get() + chunk_pos, copy_bytes);
+        data += copy_bytes;
+        size -= copy_bytes;
+        data_pos += copy_bytes;
     }
+
+    return true;
 }
 
-static bool check_package(const uint8_t * data, uint32_t size)
+static void gather_group_range(const group_t & group, uint64_t data_pos, uint8_t * dst_data, uint32_t data_size)
 {
-    if (nullptr == data || size < sizeof(block_t))
+    const group_head_t & group_head = group.head;
+    const group_body_t & group_body = group.body;
+
+    if (group_head.recv_block_count == group_head.need_block_count)
     {
-        return false;
+        read_group_data(group, data_pos, dst_data, data_size);
+        return;
     }
 
-    block_t block = *reinterpret_cast<const block_t *>(data);
-    block.decode();
+    if (0 == group_head.block_stride)
+    {
+        memset(dst_data, 0x0, data_size);
+        return;
+    }
 
-    if (s_protocol_seq != block.protocol_id)
+    const uint64_t data_end = data_pos + data_size;
+    for (uint32_t block_index = static_cast<uint32_t>(data_pos / group_head.block_stride); block_index < group_head.need_block_count; ++block_index)
     {
-        if (s_protocol_xor != block.protocol_id)
+        const uint64_t block_pos = static_cast<uint64_t>(block_index) * group_head.block_stride;
+        if (block_pos >= data_end)
         {
-            return false;
+            break;
         }
-        else if (0 == block.block_idx_h && 0 == block.block_idx_l)
+
+        const uint64_t copy_pos = std::max<uint64_t>(block_pos, data_pos);
+        const uint32_t copy_bytes = static_cast<uint32_t>(std::min<uint64_t>(block_pos + group_head.block_stride, data_end) - copy_pos);
+        if (group_body.seq_block_bitmap[block_index >> 3] & (1 << (block_index & 7)))
         {
-            return false;
+            read_group_data(group, copy_pos, dst_data + (copy_pos - data_pos), copy_bytes);
+        }
+        else
+        {
+            memset(dst_data + (copy_pos - data_pos), 0x0, copy_bytes);
         }
     }
+}
+
+static void gather_group_data(const group_t & group, uint8_t * dst_data)
+{
+    gather_group_range(group, 0, dst_data, group.head.group_bytes);
+}
+
+
+static uint64_t get_steady_microseconds()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void fill_xor_data(uint8_t * xor_data, const uint8_t * prev_data, const uint8_t * next_data, uint32_t data_size)
+{
+    for (uint32_t index = 0; index < data_size; ++index)
+    {
+        xor_data[index] = prev_data[index] ^ next_data[index];
+    }
+}
+
+struct crc32c_table_t
+{
+    uint32_t                            table[8][256];
+
+    crc32c_table_t()
+    {
+        for (uint32_t index = 0; index < 256; ++index)
+        {
+            uint32_t crc = index;
+            for (uint32_t bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+            }
+            table[0][index] = crc;
+        }
+
+        for (uint32_t index = 0; index < 256; ++index)
+        {
+            for (uint32_t slice = 1; slice < 8; ++slice)
+            {
+                table[slice][index] = (table[slice - 1][index] >> 8) ^ table[0][table[slice - 1][index] & 0xFF];
+            }
+        }
+    }
+};
+
+static const crc32c_table_t & crc32c_software_table()
+{
+    static const crc32c_table_t s_crc32c_table;
+    return s_crc32c_table;
+}
+
+/*
+ * the crc32c helpers below walk 8 bytes at a time and optionally produce the bytes they checksum:
+ * dst == nullptr            : crc over src1
+ * dst != nullptr, no src2   : copy src1 into dst and crc over it
+ * dst != nullptr, src2      : dst = src1 ^ src2 and crc over dst
+ */
+static uint32_t crc32c_process_software(uint32_t crc, uint8_t * dst, const uint8_t * src1, const uint8_t * src2, size_t size)
+{
+    const crc32c_table_t & crc_table = crc32c_software_table();
+    const uint32_t (&table)[8][256] = crc_table.table;
+
+    crc = ~crc;
+
+    uint8_t word[8];
+    size_t offset = 0;
+    for (; offset + 8 <= size; offset += 8)
+    {
+        memcpy(word, src1 + offset, 8);
+        if (nullptr != src2)
+        {
+            for (size_t index = 0; index < 8; ++index)
+            {
+                word[index] ^= src2[offset + index];
+            }
+        }
+        if (nullptr != dst)
+        {
+            memcpy(dst + offset, word, 8);
+        }
+        uint32_t low = crc ^ (static_cast<uint32_t>(word[0]) | (static_cast<uint32_t>(word[1]) << 8) | (static_cast<uint32_t>(word[2]) << 16) | (static_cast<uint32_t>(word[3]) << 24));
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^ table[3][word[4]] ^ table[2][word[5]] ^ table[1][word[6]] ^ table[0][word[7]];
+    }
+
+    for (; offset < size; ++offset)
+    {
+        uint8_t byte = src1[offset];
+        if (nullptr != src2)
+        {
+            byte ^= src2[offset];
+        }
+        if (nullptr != dst)
+        {
+            dst[offset] = byte;
+        }
+        crc = (crc >> 8) ^ table[0][(crc ^ byte) & 0xFF];
+    }
+
+    return ~crc;
+}
+
+#if defined(PACKET_XOR_CRC32C_SSE42) || defined(PACKET_XOR_CRC32C_ARMV8)
+
+#ifdef PACKET_XOR_CRC32C_SSE42
+    #ifdef _MSC_VER
+        #define PACKET_XOR_CRC32C_TARGET
+    #else
+        #define PACKET_XOR_CRC32C_TARGET    __attribute__((target("sse4.2")))
+    #endif // _MSC_VER
+    #define PACKET_XOR_CRC32C_U64(crc, value)   static_cast<uint32_t>(_mm_crc32_u64(crc, value))
+    #define PACKET_XOR_CRC32C_U8(crc, value)    _mm_crc32_u8(crc, value)
+#else
+    #define PACKET_XOR_CRC32C_TARGET
+    #define PACKET_XOR_CRC32C_U64(crc, value)   __crc32cd(crc, value)
+    #define PACKET_XOR_CRC32C_U8(crc, value)    __crc32cb(crc, value)
+#endif // PACKET_XOR_CRC32C_SSE42
+
+PACKET_XOR_CRC32C_TARGET
+static uint32_t crc32c_process_hardware(uint32_t crc, uint8_t * dst, const uint8_t * src1, const uint8_t * src2, size_t size)
+{
+    crc = ~crc;
+
+    size_t offset = 0;
+    for (; offset + 8 <= size; offset += 8)
+    {
+        uint64_t word = 0;
+        memcpy(&word, src1 + offset, 8);
+        if (nullptr != src2)
+        {
+            uint64_t other = 0;
+            memcpy(&other, src2 + offset, 8);
+            word ^= other;
+        }
+        if (nullptr != dst)
+        {
+            memcpy(dst + offset, &word, 8);
+        }
+        crc = PACKET_XOR_CRC32C_U64(crc, word);
+    }
+
+    for (; offset < size; ++offset)
+    {
+        uint8_t byte = src1[offset];
+        if (nullptr != src2)
+        {
+            byte ^= src2[offset];
+        }
+        if (nullptr != dst)
+        {
+            dst[offset] = byte;
+        }
+        crc = PACKET_XOR_CRC32C_U8(crc, byte);
+    }
+
+    return ~crc;
+}
+
+static bool crc32c_detect_hardware()
+{
+#ifdef PACKET_XOR_CRC32C_SSE42
+    #ifdef _MSC_VER
+        int cpu_info[4] = { 0x0 };
+        __cpuid(cpu_info, 1);
+        return 0 != (cpu_info[2] & (1 << 20));
+    #else
+        return 0 != __builtin_cpu_supports("sse4.2");
+    #endif // _MSC_VER
+#else
+    return true;
+#endif // PACKET_XOR_CRC32C_SSE42
+}
+
+static bool crc32c_hardware_supported()
+{
+    static const bool s_supported = crc32c_detect_hardware();
+    return s_supported;
+}
+
+#endif // PACKET_XOR_CRC32C_SSE42 || PACKET_XOR_CRC32C_ARMV8
+
+static uint32_t crc32c_process(uint32_t crc, uint8_t * dst, const uint8_t * src1, const uint8_t * src2, size_t size)
+{
+#if defined(PACKET_XOR_CRC32C_SSE42) || defined(PACKET_XOR_CRC32C_ARMV8)
+    if (crc32c_hardware_supported())
+    {
+        return crc32c_process_hardware(crc, dst, src1, src2, size);
+    }
+#endif // PACKET_XOR_CRC32C_SSE42 || PACKET_XOR_CRC32C_ARMV8
+    return crc32c_process_software(crc, dst, src1, src2, size);
+}
+
+static uint32_t crc32c_update(uint32_t crc, const uint8_t * data, size_t size)
+{
+    return crc32c_process(crc, nullptr, data, nullptr, size);
+}
+
+static uint32_t crc32c_copy(uint32_t crc, uint8_t * dst_data, const uint8_t * src_data, size_t size)
+{
+    return crc32c_process(crc, dst_data, src_data, nullptr, size);
+}
+
+static uint32_t crc32c_xor(uint32_t crc, uint8_t * xor_data, const uint8_t * prev_data, const uint8_t * next_data, size_t size)
+{
+    return crc32c_process(crc, xor_data, prev_data, next_data, size);
+}
+
+static uint32_t crc32c_multiply(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+    for (uint32_t mask = 0x80000000; 0 != mask; mask >>= 1)
+    {
+        if (0 != (a & mask))
+        {
+            product ^= b;
+        }
+        b = (b >> 1) ^ (0x82F63B78 & (0 - (b & 1)));
+    }
+    return product;
+}
+
+struct crc32c_power_table_t
+{
+    uint32_t table[64];
+
+    crc32c_power_table_t()
+    {
+        table[0] = 0x40000000;
+        for (uint32_t index = 1; index < 64; ++index)
+        {
+            table[index] = crc32c_multiply(table[index - 1], table[index - 1]);
+        }
+    }
+};
+
+/*
+ * x^(8 * size) modulo the crc32c polynomial, so that
+ * crc(a + b) == crc32c_combine(crc(a), crc(b), crc32c_shift(size of b))
+ */
+static uint32_t crc32c_shift(uint64_t size)
+{
+    static const crc32c_power_table_t s_power_table;
+
+    uint32_t shift = 0x80000000;
+    for (uint32_t index = 3; 0 != size; size >>= 1, ++index)
+    {
+        if (0 != (size & 1))
+        {
+            shift = crc32c_multiply(s_power_table.table[index % 64], shift);
+        }
+    }
+    return shift;
+}
+
+static uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint32_t shift)
+{
+    return crc32c_multiply(shift, crc1) ^ crc2;
+}
+
+static uint32_t block_head_size(bool use_ext)
+{
+    return static_cast<uint32_t>(use_ext ? sizeof(block_t) + sizeof(block_ext_t) : sizeof(block_t));
+}
+
+static void seal_block_checksum(uint8_t * buffer, uint32_t crc)
+{
+    host_to_net(&crc, sizeof(crc));
+    memcpy(buffer + sizeof(block_t) + offsetof(block_ext_t, checksum), &crc, sizeof(crc));
+}
+
+static bool verify_block_checksum(const uint8_t * data, uint32_t size)
+{
+    const uint32_t head_size = block_head_size(true);
+    const uint8_t zero_checksum[sizeof(uint32_t)] = { 0x0 };
+
+    block_ext_t block_ext = *reinterpret_cast<const block_ext_t *>(data + sizeof(block_t));
+    block_ext.decode();
+
+    uint32_t crc = crc32c_update(0, data, head_size - sizeof(zero_checksum));
+    crc = crc32c_update(crc, zero_checksum, sizeof(zero_checksum));
+    crc = crc32c_update(crc, data + head_size, size - head_size);
+
+    return crc == block_ext.checksum;
+}
+
+static bool packet_divide(const uint8_t * src_data, uint32_t src_size, uint32_t max_block_size, uint32_t xor_stride, block_ext_t block_ext, uint64_t & group_index, retransmit_cache_t * retransmit_cache, PacketBatch & dst_batch)
+{
+    if (nullptr == src_data || 0 == src_size)
+    {
+        return false;
+    }
+
+    PACKET_XOR_PROBE2(divide__begin, group_index, src_size);
+
+    const bool use_ext = (0 != block_ext.ext_flags);
+    const bool use_crc = (0 != (block_ext.ext_flags & s_ext_flag_crc32c));
+    const uint32_t head_size = block_head_size(use_ext);
+    if (max_block_size <= head_size)
+    {
+        return false;
+    }
+
+    uint32_t max_block_bytes = static_cast<uint32_t>(max_block_size - head_size);
+    uint32_t group_bytes = src_size;
+    uint32_t block_pos = 0;
+    uint32_t block_index = 0;
+    uint32_t block_count = (group_bytes + max_block_bytes - 1) / max_block_bytes;
+    if (block_count > 0x00FFFFFF)
+    {
+        return false;
+    }
+
+    const uint32_t xor_block_count = (0 == xor_stride ? 0 : (1 == block_count ? 1 : (block_count - 1) / xor_stride));
+    const bool pad_single_block = !use_ext;
+    const uint32_t max_packet_size = head_size + ((1 == block_count && !pad_single_block) ? group_bytes : max_block_bytes);
+    dst_batch.reserve(block_count + xor_block_count, static_cast<std::size_t>(block_count + xor_block_count) * max_packet_size);
+
+    std::size_t pre_packet_index = 0;
+    block_t xor_block = { 0x0 };
+    block_ext.checksum = 0;
+    block_ext.encode();
+
+    while (0 != src_size)
+    {
+        uint32_t block_bytes = std::min<uint32_t>(max_block_bytes, src_size);
+
+        block_t seq_block = { 0x0 };
+        seq_block.group_index = group_index;
+        seq_block.group_bytes = group_bytes;
+        seq_block.block_pos = block_pos;
+        seq_block.protocol_id = (use_ext ? (s_protocol_seq | s_protocol_ext) : s_protocol_seq);
+        seq_block.block_idx_h = static_cast<uint8_t>((block_index >> 16) & 0x00FF);
+        seq_block.block_idx_l = static_cast<uint16_t>(block_index & 0xFFFF);
+        seq_block.block_count = block_count;
+        seq_block.block_bytes = block_bytes;
+
+        xor_block = seq_block;
+        xor_block.protocol_id = (use_ext ? (s_protocol_xor | s_protocol_ext) : s_protocol_xor);
+
+        seq_block.encode();
+        xor_block.encode();
+
+        const uint32_t padded_block_bytes = ((1 == block_count && !pad_single_block) ? block_bytes : max_block_bytes);
+        const uint32_t seq_packet_size = head_size + padded_block_bytes;
+        const std::size_t seq_packet_index = dst_batch.size();
+        uint8_t * seq_buffer = dst_batch.append(seq_packet_size);
+        memcpy(seq_buffer, &seq_block, sizeof(seq_block));
+        if (use_ext)
+        {
+            memcpy(seq_buffer + sizeof(seq_block), &block_ext, sizeof(block_ext));
+        }
+        memset(seq_buffer + head_size + block_bytes, 0x0, padded_block_bytes - block_bytes);
+        if (use_crc)
+        {
+            uint32_t crc = crc32c_update(0, seq_buffer, head_size);
+            crc = crc32c_copy(crc, seq_buffer + head_size, src_data, block_bytes);
+            crc = crc32c_update(crc, seq_buffer + head_size + block_bytes, padded_block_bytes - block_bytes);
+            seal_block_checksum(seq_buffer, crc);
+        }
+        else
+        {
+            memcpy(seq_buffer + head_size, src_data, block_bytes);
+        }
+
+        if (nullptr != retransmit_cache)
+        {
+            cache_block(*retransmit_cache, group_index, block_index, seq_buffer, seq_packet_size);
+        }
+
+        if (0 != xor_stride)
+        {
+            if (1 == block_count)
+            {
+                dst_batch.append(dst_batch.data(seq_packet_index), seq_packet_size);
+            }
+            else if (0 != block_index && 0 == block_index % xor_stride)
+            {
+                uint8_t * xor_buffer = dst_batch.append(head_size + max_block_bytes);
+                const uint8_t * pre_buffer = dst_batch.data(pre_packet_index);
+                const uint8_t * cur_buffer = dst_batch.data(seq_packet_index);
+                memcpy(xor_buffer, &xor_block, sizeof(xor_block));
+                if (use_ext)
+                {
+                    memcpy(xor_buffer + sizeof(xor_block), &block_ext, sizeof(block_ext));
+                }
+                if (use_crc)
+                {
+                    uint32_t crc = crc32c_update(0, xor_buffer, head_size);
+                    crc = crc32c_xor(crc, xor_buffer + head_size, pre_buffer + head_size, cur_buffer + head_size, max_block_bytes);
+                    seal_block_checksum(xor_buffer, crc);
+                }
+                else
+                {
+                    fill_xor_data(xor_buffer + head_size, pre_buffer + head_size, cur_buffer + head_size, max_block_bytes);
+                }
+            }
+            pre_packet_index = seq_packet_index;
+        }
+
+        src_data += block_bytes;
+        src_size -= block_bytes;
+        block_pos += block_bytes;
+
+        ++block_index;
+    }
+
+    PACKET_XOR_PROBE2(divide__end, group_index, block_count);
+
+    ++group_index;
+
+    return true;
+}
+
+static bool insert_group_block(groups_t & groups, group_t & group, block_t & cur_block, uint32_t cur_block_index, const uint8_t * data, uint32_t size)
+{
+    group_head_t & group_head = group.head;
+    group_body_t & group_body = group.body;
+    uint32_t pre_block_index = cur_block_index - 1;
+    uint32_t nex_block_index = cur_block_index + 1;
+
+    if (s_protocol_seq == cur_block.protocol_id)
+    {
+        if (group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        {
+            return false;
+        }
+
+        const bool pre_xor = (cur_block_index > 0 && (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))));
+        const bool nex_xor = (nex_block_index < cur_block.block_count && (group_body.xor_block_bitmap[nex_block_index >> 3] & (1 << (nex_block_index & 7))));
+        std::vector<uint8_t> pre_buffer(pre_xor ? size : 0, 0x0);
+        std::vector<uint8_t> nex_buffer(nex_xor ? size : 0, 0x0);
+        if ((pre_xor && !read_group_data(group, cur_block.block_pos, &pre_buffer[0], size)) || (nex_xor && !read_group_data(group, static_cast<uint64_t>(cur_block.block_pos) + size, &nex_buffer[0], size)))
+        {
+            return false;
+        }
+
+        if (cur_block_index > 0)
+        {
+            if (pre_xor)
+            {
+                group_body.xor_block_bitmap[cur_block_index >> 3] &= ~static_cast<uint8_t>(1 << (cur_block_index & 7));
+                fill_xor_data(&pre_buffer[0], &pre_buffer[0], data, size);
+                groups.xor_processed_bytes += size;
+                block_t pre_block = cur_block;
+                pre_block.protocol_id = s_protocol_seq;
+                pre_block.block_bytes = size;
+                pre_block.block_pos -= size;
+                PACKET_XOR_PROBE4(block__recovered, group_head.group_index, pre_block_index, group_head.first_time, groups.current_time);
+                insert_group_block(groups, group, pre_block, pre_block_index, &pre_buffer[0], size);
+            }
+        }
+
+        group_head.recv_block_count += 1;
+        group_body.xor_block_bitmap[cur_block_index >> 3] &= ~static_cast<uint8_t>(1 << (cur_block_index & 7));
+        group_body.seq_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
+
+        write_group_data(groups, group, cur_block.block_pos, data, size);
+
+        if (nex_block_index < cur_block.block_count)
+        {
+            if (nex_xor)
+            {
+                group_body.xor_block_bitmap[nex_block_index >> 3] &= ~static_cast<uint8_t>(1 << (nex_block_index & 7));
+                fill_xor_data(&nex_buffer[0], &nex_buffer[0], data, size);
+                groups.xor_processed_bytes += size;
+                block_t nex_block = cur_block;
+                nex_block.protocol_id = s_protocol_seq;
+                nex_block.block_bytes = size;
+                nex_block.block_pos += size;
+                PACKET_XOR_PROBE4(block__recovered, group_head.group_index, nex_block_index, group_head.first_time, groups.current_time);
+                insert_group_block(groups, group, nex_block, nex_block_index, &nex_buffer[0], size);
+            }
+        }
+    }
+    else
+    {
+        if (0 == cur_block_index)
+        {
+            return false;
+        }
+
+        if (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        {
+            return false;
+        }
+
+        if (group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        {
+            if (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7)))
+            {
+                return false;
+            }
+            else
+            {
+                std::vector<uint8_t> pre_buffer(size, 0x0);
+                if (!read_group_data(group, cur_block.block_pos, &pre_buffer[0], size))
+                {
+                    return false;
+                }
+                fill_xor_data(&pre_buffer[0], &pre_buffer[0], data, size);
+                groups.xor_processed_bytes += size;
+                block_t pre_block = cur_block;
+                pre_block.protocol_id = s_protocol_seq;
+                pre_block.block_bytes = size;
+                pre_block.block_pos -= size;
+                PACKET_XOR_PROBE4(block__recovered, group_head.group_index, pre_block_index, group_head.first_time, groups.current_time);
+                insert_group_block(groups, group, pre_block, pre_block_index, &pre_buffer[0], size);
+            }
+        }
+        else
+        {
+            if (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7)))
+            {
+                std::vector<uint8_t> cur_buffer(size, 0x0);
+                if (!read_group_data(group, cur_block.block_pos - size, &cur_buffer[0], size))
+                {
+                    return false;
+                }
+                fill_xor_data(&cur_buffer[0], &cur_buffer[0], data, size);
+                groups.xor_processed_bytes += size;
+                cur_block.protocol_id = s_protocol_seq;
+                PACKET_XOR_PROBE4(block__recovered, group_head.group_index, cur_block_index, group_head.first_time, groups.current_time);
+                insert_group_block(groups, group, cur_block, cur_block_index, &cur_buffer[0], size);
+            }
+            else
+            {
+                group_body.xor_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
+                write_group_data(groups, group, cur_block.block_pos, data, size);
+            }
+        }
+    }
+
+    return true;
+}
+
+static std::map<uint32_t, std::vector<uint8_t>>::iterator erase_xor_block(group_body_t & group_body, std::map<uint32_t, std::vector<uint8_t>>::iterator xor_iter)
+{
+    const uint32_t block_index = xor_iter->first;
+    group_body.xor_block_bitmap[block_index >> 3] &= ~static_cast<uint8_t>(1 << (block_index & 7));
+    group_body.xor_store_bytes -= xor_iter->second.size();
+    return group_body.xor_blocks.erase(xor_iter);
+}
+
+static void fill_lazy_block(groups_t & groups, group_t & group, uint32_t block_index, uint32_t known_block_index, const std::vector<uint8_t> & xor_data, std::vector<uint8_t> & block_buffer)
+{
+    group_head_t & group_head = group.head;
+    group_body_t & group_body = group.body;
+    const uint32_t size = static_cast<uint32_t>(xor_data.size());
+
+    block_buffer.resize(size);
+    if (!read_group_data(group, static_cast<uint64_t>(known_block_index) * size, &block_buffer[0], size))
+    {
+        return;
+    }
+    fill_xor_data(&block_buffer[0], &block_buffer[0], &xor_data[0], size);
+    groups.xor_processed_bytes += size;
+
+    PACKET_XOR_PROBE4(block__recovered, group_head.group_index, block_index, group_head.first_time, groups.current_time);
+    group_head.recv_block_count += 1;
+    group_body.seq_block_bitmap[block_index >> 3] |= (1 << (block_index & 7));
+    write_group_data(groups, group, static_cast<uint64_t>(block_index) * size, &block_buffer[0], size);
+}
+
+static void recover_lazy_group(groups_t & groups, group_t & group)
+{
+    group_head_t & group_head = group.head;
+    group_body_t & group_body = group.body;
+    std::map<uint32_t, std::vector<uint8_t>> & xor_blocks = group_body.xor_blocks;
+    if (xor_blocks.empty() || group_head.recv_block_count == group_head.need_block_count)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> block_buffer;
+
+    for (std::map<uint32_t, std::vector<uint8_t>>::iterator iter = xor_blocks.begin(); xor_blocks.end() != iter; ++iter)
+    {
+        const uint32_t cur_block_index = iter->first;
+        const uint32_t pre_block_index = cur_block_index - 1;
+        if ((group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7))) && !(group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))))
+        {
+            fill_lazy_block(groups, group, cur_block_index, pre_block_index, iter->second, block_buffer);
+        }
+    }
+
+    for (std::map<uint32_t, std::vector<uint8_t>>::reverse_iterator iter = xor_blocks.rbegin(); xor_blocks.rend() != iter; ++iter)
+    {
+        const uint32_t cur_block_index = iter->first;
+        const uint32_t pre_block_index = cur_block_index - 1;
+        if ((group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))) && !(group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7))))
+        {
+            fill_lazy_block(groups, group, pre_block_index, cur_block_index, iter->second, block_buffer);
+        }
+    }
+
+    std::map<uint32_t, std::vector<uint8_t>>::iterator iter = xor_blocks.begin();
+    while (xor_blocks.end() != iter)
+    {
+        const uint32_t cur_block_index = iter->first;
+        const uint32_t pre_block_index = cur_block_index - 1;
+        if ((group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))) && (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7))))
+        {
+            iter = erase_xor_block(group_body, iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+static bool insert_lazy_block(groups_t & groups, group_t & group, const block_t & cur_block, uint32_t cur_block_index, const uint8_t * data, uint32_t size)
+{
+    group_head_t & group_head = group.head;
+    group_body_t & group_body = group.body;
+    uint32_t pre_block_index = cur_block_index - 1;
+    uint32_t nex_block_index = cur_block_index + 1;
+
+    if (s_protocol_seq == cur_block.protocol_id)
+    {
+        if (group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        {
+            return false;
+        }
+
+        group_head.recv_block_count += 1;
+        group_body.seq_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
+        write_group_data(groups, group, cur_block.block_pos, data, size);
+
+        if (cur_block_index > 0 && (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))) && (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7))))
+        {
+            erase_xor_block(group_body, group_body.xor_blocks.find(cur_block_index));
+        }
+
+        if (nex_block_index < cur_block.block_count && (group_body.xor_block_bitmap[nex_block_index >> 3] & (1 << (nex_block_index & 7))) && (group_body.seq_block_bitmap[nex_block_index >> 3] & (1 << (nex_block_index & 7))))
+        {
+            erase_xor_block(group_body, group_body.xor_blocks.find(nex_block_index));
+        }
+    }
+    else
+    {
+        if (0 == cur_block_index)
+        {
+            return false;
+        }
+
+        if (group_body.xor_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7)))
+        {
+            return false;
+        }
+
+        if ((group_body.seq_block_bitmap[cur_block_index >> 3] & (1 << (cur_block_index & 7))) && (group_body.seq_block_bitmap[pre_block_index >> 3] & (1 << (pre_block_index & 7))))
+        {
+            return false;
+        }
+
+        group_body.xor_block_bitmap[cur_block_index >> 3] |= (1 << (cur_block_index & 7));
+        group_body.xor_blocks[cur_block_index].assign(data, data + size);
+        group_body.xor_store_bytes += size;
+    }
+
+    if (nex_block_index == cur_block.block_count)
+    {
+        group_head.tail_arrived = true;
+    }
+
+    if (group_head.tail_arrived && group_head.recv_block_count + group_body.xor_blocks.size() >= group_head.need_block_count)
+    {
+        recover_lazy_group(groups, group);
+    }
+
+    return true;
+}
+
+static bool check_block(const block_t & block, uint32_t head_size, uint32_t size)
+{
+    if (s_protocol_seq != block.protocol_id)
+    {
+        if (s_protocol_xor != block.protocol_id)
+        {
+            return false;
+        }
+        else if (0 == block.block_idx_h && 0 == block.block_idx_l)
+        {
+            return false;
+        }
+    }
+
+    uint32_t block_index = static_cast<uint32_t>(static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
+    if (block_index >= block.block_count)
+    {
+        return false;
+    }
+    else if (block_index + 1 == block.block_count)
+    {
+        if (static_cast<uint64_t>(head_size) + block.block_bytes > size || static_cast<uint64_t>(block.block_pos) + block.block_bytes < block.group_bytes)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if (static_cast<uint64_t>(head_size) + block.block_bytes != size || static_cast<uint64_t>(block.block_pos) + block.block_bytes > block.group_bytes)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool parse_block(const uint8_t * data, uint32_t size, block_t & block, block_ext_t & block_ext, uint32_t & head_size)
+{
+    if (nullptr == data || size < sizeof(block_t))
+    {
+        return false;
+    }
+
+    block = *reinterpret_cast<const block_t *>(data);
+    block.decode();
+
+    memset(&block_ext, 0x0, sizeof(block_ext));
+    head_size = block_head_size(false);
+
+    if (0 != (block.protocol_id & s_protocol_ext))
+    {
+        if (size < block_head_size(true))
+        {
+            return false;
+        }
+
+        block_ext = *reinterpret_cast<const block_ext_t *>(data + sizeof(block_t));
+        block_ext.decode();
+
+        head_size = block_head_size(true);
+        block.protocol_id &= ~s_protocol_ext;
+    }
+
+    return check_block(block, head_size, size);
+}
+
+static bool view_block(const block_view_t & block_view, uint32_t size, block_t & block, block_ext_t & block_ext, uint32_t & head_size)
+{
+    block.group_index = block_view.group_index;
+    block.protocol_id = block_view.protocol_id;
+    block.block_idx_h = static_cast<uint8_t>(block_view.block_index >> 16);
+    block.block_idx_l = static_cast<uint16_t>(block_view.block_index & 0xFFFF);
+    block.block_count = block_view.block_count;
+    block.block_bytes = block_view.block_bytes;
+    block.block_pos = block_view.block_pos;
+    block.group_bytes = block_view.group_bytes;
+
+    head_size = block_view.head_bytes;
+
+    memset(&block_ext, 0x0, sizeof(block_ext));
+    if (block_head_size(true) == head_size)
+    {
+        block_ext.ext_flags = block_view.ext_flags;
+        block_ext.frame_class = block_view.frame_class;
+        block_ext.deadline_millisecond = block_view.deadline_millisecond;
+        block_ext.checksum = block_view.checksum;
+    }
+
+    return (block_head_size(false) == head_size || block_head_size(true) == head_size) && size >= head_size && check_block(block, head_size, size);
+}
+
+static bool parse_parity_block(const uint8_t * data, uint32_t size, block_t & block, uint32_t & head_size)
+{
+    if (nullptr == data || size < sizeof(block_t))
+    {
+        return false;
+    }
+
+    block = *reinterpret_cast<const block_t *>(data);
+    block.decode();
+
+    head_size = block_head_size(0 != (block.protocol_id & s_protocol_ext));
+    if (s_protocol_parity != (block.protocol_id & ~s_protocol_ext) || size < head_size)
+    {
+        return false;
+    }
+
+    if (block.block_count < 2 || block.block_count > s_max_parity_window || block.block_bytes < sizeof(block_t) || static_cast<uint64_t>(head_size) + block.block_bytes != size)
+    {
+        return false;
+    }
+
+    if (head_size != sizeof(block_t))
+    {
+        block_ext_t block_ext = *reinterpret_cast<const block_ext_t *>(data + sizeof(block_t));
+        if (0 != (block_ext.ext_flags & s_ext_flag_crc32c) && !verify_block_checksum(data, size))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool insert_group_block(const void * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    block_t block = { 0x0 };
+    block_ext_t block_ext = { 0x0 };
+    uint32_t head_size = 0;
+    const bool parsed = (groups.hint_data == data ? view_block(*groups.hint_view, size, block, block_ext, head_size) : parse_block(reinterpret_cast<const uint8_t *>(data), size, block, block_ext, head_size));
+    uint32_t new_block_index = static_cast<uint32_t>(static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
+    const uint64_t current_time = groups.current_time;
+
+    if (!parsed)
+    {
+        PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_malformed, current_time);
+        return false;
+    }
+
+    PACKET_XOR_PROBE4(block__received, block.group_index, new_block_index, block.protocol_id, current_time);
+
+    if (0 != (block_ext.ext_flags & s_ext_flag_crc32c) && !groups.skip_checksum && !verify_block_checksum(reinterpret_cast<const uint8_t *>(data), size))
+    {
+        PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_checksum, current_time);
+        groups.checksum_error_blocks += 1;
+        return false;
+    }
+
+    if (block.group_index < groups.min_group_index)
+    {
+        PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_stale, current_time);
+        return false;
+    }
+
+    const std::map<uint64_t, group_t>::const_iterator group_iter = groups.group_items.find(block.group_index);
+    const uint32_t block_stride = (groups.group_items.end() != group_iter ? group_iter->second.head.block_stride : (new_block_index + 1 < block.block_count ? block.block_bytes : (block.block_count > 1 ? block.block_pos / (block.block_count - 1) : block.group_bytes)));
+    const uint64_t group_extent = static_cast<uint64_t>(block.block_count) * block_stride;
+    const uint32_t payload_size = static_cast<uint32_t>(size - head_size);
+    if ((new_block_index + 1 < block.block_count ? payload_size != block_stride : payload_size < block_stride) || static_cast<uint64_t>(new_block_index) * block_stride != block.block_pos || group_extent < block.group_bytes || group_extent - block_stride >= std::max<uint64_t>(block.group_bytes, 1))
+    {
+        PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_malformed, current_time);
+        return false;
+    }
+
+    if (groups.group_items.end() == group_iter && !admit_group(groups, block.group_index, block.block_count, block.group_bytes, block.block_pos, block_stride))
+    {
+        PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_budget, current_time);
+        return false;
+    }
+
+    groups.new_group_index = block.group_index;
+
+    group_t & group = groups.group_items[groups.new_group_index];
+    group_head_t & group_head = group.head;
+    group_body_t & group_body = group.body;
+
+    if (0 == group_head.need_block_count)
+    {
+        group_head.group_index = block.group_index;
+        group_head.group_bytes = block.group_bytes;
+        group_head.need_block_count = block.block_count;
+        group_head.aggregate = (0 != (block_ext.ext_flags & s_ext_flag_aggregate));
+        group_head.object = (0 != (block_ext.ext_flags & s_ext_flag_object));
+        group_head.frame_class = block_ext.frame_class;
+        group_head.block_stride = block_stride;
+
+        group_body.seq_block_bitmap.resize((block.block_count + 7) / 8, 0x0);
+        group_body.xor_block_bitmap.resize((block.block_count + 7) / 8, 0x0);
+
+        if (groups.lazy_recovery)
+        {
+            insert_lazy_block(groups, group, block, new_block_index, reinterpret_cast<const uint8_t *>(data) + head_size, block_stride);
+        }
+        else
+        {
+            if (s_protocol_seq == block.protocol_id)
+            {
+                group_head.recv_block_count += 1;
+                group_body.xor_block_bitmap[new_block_index >> 3] &= ~static_cast<uint8_t>(1 << (new_block_index & 7));
+                group_body.seq_block_bitmap[new_block_index >> 3] |= (1 << (new_block_index & 7));
+            }
+            else
+            {
+                group_body.xor_block_bitmap[new_block_index >> 3] |= (1 << (new_block_index & 7));
+            }
+
+            write_group_data(groups, group, block.block_pos, reinterpret_cast<const uint8_t *>(data) + head_size, block_stride);
+        }
+        update_group_memory(groups, group);
+
+        group_head.first_time = current_time;
+        group_head.last_time = current_time;
+
+        PACKET_XOR_PROBE4(group__created, group_head.group_index, group_head.need_block_count, group_head.group_bytes, current_time);
+        if (group_head.recv_block_count == group_head.need_block_count)
+        {
+            PACKET_XOR_PROBE4(group__completed, group_head.group_index, group_head.need_block_count, group_head.first_time, current_time);
+        }
+
+        uint32_t expire_microseconds = max_delay_microseconds * (group_head.need_block_count / 100 + 1);
+        if (0 != (block_ext.ext_flags & s_ext_flag_frame_class) && 0 != block_ext.deadline_millisecond)
+        {
+            expire_microseconds = static_cast<uint32_t>(block_ext.deadline_millisecond) * 1000;
+        }
+        else if (groups.expire_estimator.enabled)
+        {
+            expire_microseconds = estimate_expire_microseconds(groups.expire_estimator, group_head.need_block_count, expire_microseconds);
+        }
+
+        decode_timer_t decode_timer = { 0x0 };
+        decode_timer.group_index = block.group_index;
+        decode_timer.decode_seconds = static_cast<uint32_t>((current_time + expire_microseconds) / 1000000);
+        decode_timer.decode_microseconds = static_cast<uint32_t>((current_time + expire_microseconds) % 1000000);
+
+        groups.decode_timer_list.push_back(decode_timer);
+
+        if (0 != groups.nack_delay_microseconds)
+        {
+            group_head.nack_time = current_time + groups.nack_delay_microseconds;
+            if (0 == groups.next_nack_time || group_head.nack_time < groups.next_nack_time)
+            {
+                groups.next_nack_time = group_head.nack_time;
+            }
+        }
+    }
+    else if (group_head.recv_block_count < group_head.need_block_count)
+    {
+        if (block.group_index != group_head.group_index || block.group_bytes != group_head.group_bytes || block.block_count != group_head.need_block_count)
+        {
+            PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_mismatch, current_time);
+            return false;
+        }
+
+        const bool inserted = (groups.lazy_recovery ? insert_lazy_block(groups, group, block, new_block_index, reinterpret_cast<const uint8_t *>(data) + head_size, block_stride) : insert_group_block(groups, group, block, new_block_index, reinterpret_cast<const uint8_t *>(data) + head_size, block_stride));
+        if (!inserted)
+        {
+            PACKET_XOR_PROBE4(block__rejected, block.group_index, new_block_index, s_reject_duplicate, current_time);
+        }
+        else if (group_head.recv_block_count == group_head.need_block_count)
+        {
+            PACKET_XOR_PROBE4(group__completed, group_head.group_index, group_head.need_block_count, group_head.first_time, current_time);
+        }
+        if (inserted && groups.expire_estimator.enabled)
+        {
+            expire_estimator_t & estimator = groups.expire_estimator;
+            estimator_sample(estimator.gap_valid, estimator.gap_average, estimator.gap_deviation, static_cast<double>(current_time - group_head.last_time));
+        }
+        group_head.last_time = current_time;
+        update_group_memory(groups, group);
+        enforce_memory_budget(groups, block.group_index);
+        return inserted;
+    }
+
+    return true;
+}
+
+static void remove_expired_blocks(groups_t & groups)
+{
+    std::map<uint64_t, group_t> & group_items = groups.group_items;
+    for (std::map<uint64_t, group_t>::iterator iter = group_items.begin(); group_items.end() != iter; iter = group_items.begin())
+    {
+        if (iter->first >= groups.min_group_index)
+        {
+            break;
+        }
+        remove_group(groups, iter);
+    }
+}
+
+static bool parse_stream_repair(const uint8_t * data, uint32_t size, stream_repair_t & stream_repair)
+{
+    if (nullptr == data || size <= sizeof(stream_repair_t))
+    {
+        return false;
+    }
+
+    stream_repair = *reinterpret_cast<const stream_repair_t *>(data);
+    stream_repair.decode();
+    if (s_protocol_repair != stream_repair.protocol_id || 0 == stream_repair.window_size || stream_repair.window_size > s_max_stream_window || stream_repair.window_end + 1 < stream_repair.window_size || sizeof(stream_repair_t) + stream_repair.repair_bytes != size)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static bool classify_package(const uint8_t * data, uint32_t size, block_view_t & block_view)
+{
+    memset(&block_view, 0x0, sizeof(block_view));
+
+    if (nullptr != data && size > sizeof(path_head_t) && s_protocol_path == reinterpret_cast<const path_head_t *>(data)->protocol_id)
+    {
+        data += sizeof(path_head_t);
+        size -= sizeof(path_head_t);
+        block_view.head_offset += sizeof(path_head_t);
+    }
+
+    if (nullptr != data && size > sizeof(stream_repair_t) && s_protocol_repair == reinterpret_cast<const stream_repair_t *>(data)->protocol_id)
+    {
+        stream_repair_t stream_repair = { 0x0 };
+        if (!parse_stream_repair(data, size, stream_repair))
+        {
+            block_view.head_offset = 0;
+            return false;
+        }
+
+        block_view.block_bytes = stream_repair.repair_bytes;
+        block_view.head_bytes = sizeof(stream_repair_t);
+        block_view.protocol_id = s_protocol_repair;
+        return true;
+    }
+
+    if (nullptr != data && size > sizeof(stream_head_t) && s_protocol_stream == reinterpret_cast<const stream_head_t *>(data)->protocol_id)
+    {
+        data += sizeof(stream_head_t);
+        size -= sizeof(stream_head_t);
+        block_view.head_offset += sizeof(stream_head_t);
+    }
+
+    block_t block = { 0x0 };
+    block_ext_t block_ext = { 0x0 };
+    uint32_t head_size = 0;
+    if (parse_block(data, size, block, block_ext, head_size))
+    {
+        block_view.group_index = block.group_index;
+        block_view.block_index = (static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
+        block_view.block_count = block.block_count;
+        block_view.block_bytes = block.block_bytes;
+        block_view.block_pos = block.block_pos;
+        block_view.group_bytes = block.group_bytes;
+        block_view.head_bytes = head_size;
+        block_view.protocol_id = block.protocol_id;
+        block_view.ext_flags = block_ext.ext_flags;
+        block_view.frame_class = block_ext.frame_class;
+        block_view.deadline_millisecond = block_ext.deadline_millisecond;
+        block_view.checksum = block_ext.checksum;
+        return true;
+    }
+
+    if (parse_parity_block(data, size, block, head_size))
+    {
+        block_view.group_index = block.group_index;
+        block_view.block_count = block.block_count;
+        block_view.block_bytes = block.block_bytes;
+        block_view.head_bytes = head_size;
+        block_view.protocol_id = s_protocol_parity;
+        return true;
+    }
+
+    block_view.head_offset = 0;
+    return false;
+}
+
+static bool check_package(const uint8_t * data, uint32_t size)
+{
+    block_view_t block_view;
+    return classify_package(data, size, block_view);
+}
+
+static uint32_t classify_candidates(const uint8_t * protocol_ids, std::size_t count)
+{
+    uint32_t candidate_mask = 0;
+    std::size_t index = 0;
+
+#ifdef PACKET_XOR_CLASSIFY_SSE2
+    if (16 == count)
+    {
+        const __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i *>(protocol_ids));
+        const __m128i plain_delta = _mm_sub_epi8(ids, _mm_set1_epi8(static_cast<char>(s_protocol_seq)));
+        const __m128i plain_range = _mm_set1_epi8(static_cast<char>(s_protocol_repair - s_protocol_seq));
+        const __m128i ext_delta = _mm_sub_epi8(ids, _mm_set1_epi8(static_cast<char>(s_protocol_seq | s_protocol_ext)));
+        const __m128i ext_range = _mm_set1_epi8(static_cast<char>(s_protocol_parity - s_protocol_seq));
+        const __m128i plain_hit = _mm_cmpeq_epi8(_mm_min_epu8(plain_delta, plain_range), plain_delta);
+        const __m128i ext_hit = _mm_cmpeq_epi8(_mm_min_epu8(ext_delta, ext_range), ext_delta);
+        candidate_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(plain_hit, ext_hit)));
+        index = count;
+    }
+#endif // PACKET_XOR_CLASSIFY_SSE2
+
+    for (; index < count; ++index)
+    {
+        const uint8_t protocol_id = protocol_ids[index];
+        if (static_cast<uint8_t>(protocol_id - s_protocol_seq) <= s_protocol_repair - s_protocol_seq || static_cast<uint8_t>(protocol_id - (s_protocol_seq | s_protocol_ext)) <= s_protocol_parity - s_protocol_seq)
+        {
+            candidate_mask |= (1u << index);
+        }
+    }
+
+    return candidate_mask;
+}
+
+static std::size_t classify_batch(const PacketBatch & src_batch, std::vector<uint64_t> & valid_mask, std::vector<block_view_t> & block_views)
+{
+    const std::size_t packet_count = src_batch.size();
+    valid_mask.assign((packet_count + 63) / 64, 0);
+    block_views.resize(packet_count);
+
+    std::size_t valid_count = 0;
+    uint8_t protocol_ids[16];
+    for (std::size_t base_index = 0; base_index < packet_count; base_index += 16)
+    {
+        const std::size_t count = std::min<std::size_t>(16, packet_count - base_index);
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            protocol_ids[index] = (src_batch.length(base_index + index) > sizeof(stream_head_t) ? src_batch.data(base_index + index)[offsetof(block_t, protocol_id)] : 0x0);
+        }
+
+        const uint32_t candidate_mask = classify_candidates(protocol_ids, count);
+        for (std::size_t index = 0; index < count; ++index)
+        {
+            const std::size_t packet_index = base_index + index;
+            block_view_t & block_view = block_views[packet_index];
+            if (0 != (candidate_mask & (1u << index)) && classify_package(src_batch.data(packet_index), src_batch.length(packet_index), block_view))
+            {
+                valid_mask[packet_index / 64] |= (1ULL << (packet_index % 64));
+                ++valid_count;
+            }
+            else
+            {
+                memset(&block_view, 0x0, sizeof(block_view));
+            }
+        }
+    }
+
+    return valid_count;
+}
+
+static void order_decode_timer(groups_t & groups, uint64_t group_index)
+{
+    std::list<decode_timer_t> & timer_list = groups.decode_timer_list;
+    if (timer_list.empty() || timer_list.back().group_index != group_index)
+    {
+        return;
+    }
+
+    std::list<decode_timer_t>::iterator iter = timer_list.begin();
+    while (timer_list.end() != iter && iter->group_index < group_index)
+    {
+        ++iter;
+    }
+    timer_list.splice(iter, timer_list, std::prev(timer_list.end()));
+}
+
+static const parity_slot_t * find_parity_slot(const cross_parity_t & cross_parity, uint64_t group_index)
+{
+    const parity_slot_t & slot = cross_parity.history[group_index % cross_parity.history.size()];
+    return (slot.group_index == group_index && !slot.block_data.empty()) ? &slot : nullptr;
+}
+
+static bool recover_parity_group(const std::vector<uint8_t> & parity_data, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    block_t parity_block = { 0x0 };
+    uint32_t parity_head_size = 0;
+    parse_parity_block(parity_data.data(), static_cast<uint32_t>(parity_data.size()), parity_block, parity_head_size);
+
+    if (parity_block.group_index + parity_block.block_count <= groups.min_group_index)
+    {
+        return true;
+    }
+
+    const cross_parity_t & cross_parity = groups.cross_parity;
+    uint64_t lost_group_index = 0;
+    uint32_t lost_group_count = 0;
+    for (uint64_t group_index = parity_block.group_index; group_index < parity_block.group_index + parity_block.block_count; ++group_index)
+    {
+        if (nullptr == find_parity_slot(cross_parity, group_index))
+        {
+            lost_group_index = group_index;
+            ++lost_group_count;
+        }
+    }
+
+    if (lost_group_count > 1)
+    {
+        return false;
+    }
+
+    if (0 == lost_group_count || lost_group_index < groups.min_group_index || groups.group_items.end() != groups.group_items.find(lost_group_index))
+    {
+        return true;
+    }
+
+    const uint32_t block_size = parity_block.block_bytes;
+    std::vector<uint8_t> block_data(parity_data.begin() + parity_head_size, parity_data.end());
+    for (uint64_t group_index = parity_block.group_index; group_index < parity_block.group_index + parity_block.block_count; ++group_index)
+    {
+        if (group_index != lost_group_index)
+        {
+            const parity_slot_t * slot = find_parity_slot(cross_parity, group_index);
+            fill_xor_data(&block_data[0], &block_data[0], slot->block_data.data(), static_cast<uint32_t>(std::min<std::size_t>(slot->block_data.size(), block_size)));
+        }
+    }
+
+    block_t block = *reinterpret_cast<const block_t *>(block_data.data());
+    block.decode();
+    const uint64_t lost_size = static_cast<uint64_t>(block_head_size(0 != (block.protocol_id & s_protocol_ext))) + block.block_bytes;
+    if (block.group_index != lost_group_index || 1 != block.block_count || lost_size > block_size)
+    {
+        return true;
+    }
+
+    if (insert_group_block(block_data.data(), static_cast<uint32_t>(lost_size), groups, max_delay_microseconds))
+    {
+        PACKET_XOR_PROBE4(block__recovered, lost_group_index, 0, (cross_parity.gap_group_index == lost_group_index ? cross_parity.gap_time : groups.current_time), groups.current_time);
+        groups.cross_parity.recovered_groups += 1;
+        order_decode_timer(groups, lost_group_index);
+    }
+
+    return true;
+}
+
+static void remember_parity_block(const uint8_t * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    cross_parity_t & cross_parity = groups.cross_parity;
+    if (!cross_parity.active)
+    {
+        return;
+    }
+
+    block_t block = *reinterpret_cast<const block_t *>(data);
+    block.decode();
+    if (1 != block.block_count)
+    {
+        return;
+    }
+
+    parity_slot_t & slot = cross_parity.history[block.group_index % cross_parity.history.size()];
+    slot.group_index = block.group_index;
+    slot.block_data.assign(data, data + size);
+
+    std::list<std::vector<uint8_t>>::iterator iter = cross_parity.pending.begin();
+    while (cross_parity.pending.end() != iter)
+    {
+        if (recover_parity_group(*iter, groups, max_delay_microseconds))
+        {
+            iter = cross_parity.pending.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+static bool insert_parity_block(const void * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    block_t block = { 0x0 };
+    uint32_t head_size = 0;
+    if (!parse_parity_block(reinterpret_cast<const uint8_t *>(data), size, block, head_size))
+    {
+        return false;
+    }
+
+    cross_parity_t & cross_parity = groups.cross_parity;
+    cross_parity.active = true;
+
+    std::vector<uint8_t> parity_data(reinterpret_cast<const uint8_t *>(data), reinterpret_cast<const uint8_t *>(data) + size);
+    if (!recover_parity_group(parity_data, groups, max_delay_microseconds))
+    {
+        if (cross_parity.pending.size() >= s_max_pending_parities)
+        {
+            cross_parity.pending.pop_front();
+        }
+        cross_parity.pending.emplace_back(std::move(parity_data));
+    }
+
+    return true;
+}
+
+static bool wait_parity_gap(groups_t & groups, uint64_t group_index, uint32_t max_delay_microseconds)
+{
+    cross_parity_t & cross_parity = groups.cross_parity;
+    if (!cross_parity.active || group_index <= groups.min_group_index || groups.group_items.end() != groups.group_items.find(groups.min_group_index))
+    {
+        return false;
+    }
+
+    const uint64_t current_time = groups.current_time;
+    if (0 == cross_parity.gap_deadline || cross_parity.gap_group_index != groups.min_group_index)
+    {
+        const uint32_t expire_microseconds = (groups.expire_estimator.enabled ? estimate_expire_microseconds(groups.expire_estimator, 1, max_delay_microseconds) : max_delay_microseconds);
+        cross_parity.gap_group_index = groups.min_group_index;
+        cross_parity.gap_time = current_time;
+        cross_parity.gap_deadline = current_time + expire_microseconds;
+    }
+
+    return current_time < cross_parity.gap_deadline;
+}
+
+static std::vector<uint8_t> & acquire_frame(groups_t & groups, uint32_t frame_bytes, std::list<std::vector<uint8_t>> & dst_list)
+{
+    if (groups.free_frames.empty())
+    {
+        dst_list.emplace_back(frame_bytes);
+    }
+    else
+    {
+        dst_list.emplace_back(std::move(groups.free_frames.back()));
+        groups.free_frames.pop_back();
+        dst_list.back().resize(frame_bytes);
+    }
+    return dst_list.back();
+}
+
+static void recycle_frame(groups_t & groups, std::vector<uint8_t> && frame)
+{
+    if (groups.free_frames.size() < s_max_free_frames && 0 != frame.capacity())
+    {
+        groups.free_frames.emplace_back(std::move(frame));
+    }
+}
+
+static std::size_t deliver_records(groups_t & groups, const uint8_t * data, uint32_t size, std::list<std::vector<uint8_t>> & dst_list, PacketBatch * dst_batch, reserve_callback_t reserve_callback, decode_callback_t decode_callback, void * user_data)
+{
+    std::size_t record_count = 0;
+    uint32_t record_pos = 0;
+    while (record_pos + s_aggregate_record_head_bytes <= size)
+    {
+        const uint32_t record_bytes = (static_cast<uint32_t>(data[record_pos]) << 8) | static_cast<uint32_t>(data[record_pos + 1]);
+        record_pos += s_aggregate_record_head_bytes;
+        if (0 == record_bytes || record_pos + record_bytes > size)
+        {
+            break;
+        }
+
+        if (nullptr != reserve_callback)
+        {
+            uint8_t * record = (*reserve_callback)(user_data, record_bytes);
+            if (nullptr == record)
+            {
+                record_pos += record_bytes;
+                continue;
+            }
+            memcpy(record, data + record_pos, record_bytes);
+            (*decode_callback)(user_data, record, record_bytes);
+        }
+        else if (nullptr != decode_callback)
+        {
+            (*decode_callback)(user_data, data + record_pos, record_bytes);
+        }
+        else if (nullptr != dst_batch)
+        {
+            dst_batch->append(data + record_pos, record_bytes);
+        }
+        else
+        {
+            std::vector<uint8_t> & record = acquire_frame(groups, record_bytes, dst_list);
+            memcpy(record.data(), data + record_pos, record_bytes);
+        }
+
+        record_pos += record_bytes;
+        ++record_count;
+    }
+    return record_count;
+}
+
+static void close_object_output(object_output_t & output, bool close_file)
+{
+#ifndef _MSC_VER
+    if (nullptr != output.mapped_data)
+    {
+        munmap(output.mapped_data, static_cast<size_t>(output.mapped_bytes));
+    }
+    if (close_file && -1 != output.file_descriptor)
+    {
+        close(output.file_descriptor);
+        output.file_descriptor = -1;
+    }
+#endif // _MSC_VER
+    output.mapped_data = nullptr;
+    output.mapped_bytes = 0;
+}
+
+static bool map_object_output(object_output_t & output, const object_head_t & object_head)
+{
+    if (nullptr != output.mapped_data && output.object_id == object_head.object_id && output.mapped_bytes == object_head.object_bytes)
+    {
+        return true;
+    }
+
+    close_object_output(output, false);
+
+#ifndef _MSC_VER
+    if (-1 == output.file_descriptor || static_cast<uint64_t>(static_cast<off_t>(object_head.object_bytes)) != object_head.object_bytes || static_cast<uint64_t>(static_cast<size_t>(object_head.object_bytes)) != object_head.object_bytes)
+    {
+        return false;
+    }
+
+    if (0 != ftruncate(output.file_descriptor, static_cast<off_t>(object_head.object_bytes)))
+    {
+        return false;
+    }
+
+    void * mapped_data = mmap(nullptr, static_cast<size_t>(object_head.object_bytes), PROT_READ | PROT_WRITE, MAP_SHARED, output.file_descriptor, 0);
+    if (MAP_FAILED == mapped_data)
+    {
+        return false;
+    }
+
+    output.mapped_data = reinterpret_cast<uint8_t *>(mapped_data);
+    output.mapped_bytes = object_head.object_bytes;
+    output.object_id = object_head.object_id;
+
+    return true;
+#else
+    return false;
+#endif // _MSC_VER
+}
+
+static std::size_t deliver_object(groups_t & groups, const group_t & group)
+{
+    const group_head_t & group_head = group.head;
+    if (group_head.group_bytes <= sizeof(object_head_t) || group_head.block_stride < sizeof(object_head_t) || 0 == (group.body.seq_block_bitmap[0] & 0x01))
+    {
+        groups.object_dropped_windows += 1;
+        return 0;
+    }
+
+    object_head_t object_head = { 0x0 };
+    gather_group_range(group, 0, reinterpret_cast<uint8_t *>(&object_head), sizeof(object_head));
+    object_head.decode();
+
+    const uint32_t window_bytes = static_cast<uint32_t>(group_head.group_bytes - sizeof(object_head));
+    if (object_head.object_offset > object_head.object_bytes || window_bytes > object_head.object_bytes - object_head.object_offset || !map_object_output(groups.object_output, object_head))
+    {
+        groups.object_dropped_windows += 1;
+        return 0;
+    }
+
+    gather_group_range(group, sizeof(object_head), groups.object_output.mapped_data + object_head.object_offset, window_bytes);
+    groups.object_windows += 1;
+
+    if (nullptr != groups.object_output.object_callback)
+    {
+        (*groups.object_output.object_callback)(groups.object_output.user_data, object_head.object_id, object_head.object_offset, window_bytes, object_head.object_bytes);
+    }
+
+    return 1;
+}
+
+static void emit_progress(groups_t & groups, group_t & group, uint32_t progress_bytes)
+{
+    group_head_t & group_head = group.head;
+    if (progress_bytes <= group_head.progress_bytes)
+    {
+        return;
+    }
+
+    const uint32_t emit_bytes = progress_bytes - group_head.progress_bytes;
+    groups.frame_buffer.resize(emit_bytes);
+    gather_group_range(group, group_head.progress_bytes, groups.frame_buffer.data(), emit_bytes);
+    (*groups.progress_callback)(groups.progress_user_data, group_head.group_index, group_head.progress_bytes, groups.frame_buffer.data(), emit_bytes, group_head.group_bytes);
+    group_head.progress_bytes = progress_bytes;
+}
+
+static void advance_progress(groups_t & groups)
+{
+    if (nullptr == groups.progress_callback || groups.decode_timer_list.empty())
+    {
+        return;
+    }
+
+    std::map<uint64_t, group_t>::iterator group_iter = groups.group_items.find(groups.decode_timer_list.front().group_index);
+    if (groups.group_items.end() == group_iter || group_iter->second.head.aggregate || group_iter->second.head.object || 0 == group_iter->second.head.block_stride)
+    {
+        return;
+    }
+
+    group_t & group = group_iter->second;
+    group_head_t & group_head = group.head;
+    uint32_t block_index = group_head.progress_blocks;
+    while (block_index < group_head.need_block_count && (group.body.seq_block_bitmap[block_index >> 3] & (1 << (block_index & 7))))
+    {
+        ++block_index;
+    }
+
+    if (block_index != group_head.progress_blocks)
+    {
+        group_head.progress_blocks = block_index;
+        emit_progress(groups, group, static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(block_index) * group_head.block_stride, group_head.group_bytes)));
+    }
+}
+
+static std::size_t deliver_group(groups_t & groups, group_t & group, std::list<std::vector<uint8_t>> & dst_list, PacketBatch * dst_batch, reserve_callback_t reserve_callback, decode_callback_t decode_callback, void * user_data)
+{
+    PACKET_XOR_PROBE4(frame__delivered, group.head.group_index, group.head.group_bytes, group.head.first_time, groups.current_time);
+
+    if (group.head.object)
+    {
+        return deliver_object(groups, group);
+    }
+
+    if (nullptr != groups.progress_callback && !group.head.aggregate)
+    {
+        emit_progress(groups, group, group.head.group_bytes);
+        group.head.progress_done = true;
+        if (nullptr != groups.complete_callback)
+        {
+            (*groups.complete_callback)(groups.progress_user_data, group.head.group_index, group.head.group_bytes, true);
+        }
+        return 1;
+    }
+
+    if (group.head.aggregate)
+    {
+        groups.frame_buffer.resize(group.head.group_bytes);
+        gather_group_data(group, groups.frame_buffer.data());
+        return deliver_records(groups, groups.frame_buffer.data(), group.head.group_bytes, dst_list, dst_batch, reserve_callback, decode_callback, user_data);
+    }
+
+    if (nullptr != reserve_callback)
+    {
+        uint8_t * frame = (*reserve_callback)(user_data, group.head.group_bytes);
+        if (nullptr == frame)
+        {
+            return 0;
+        }
+        gather_group_data(group, frame);
+        (*decode_callback)(user_data, frame, group.head.group_bytes);
+    }
+    else if (nullptr != decode_callback)
+    {
+        groups.frame_buffer.resize(group.head.group_bytes);
+        gather_group_data(group, groups.frame_buffer.data());
+        (*decode_callback)(user_data, groups.frame_buffer.data(), group.head.group_bytes);
+    }
+    else if (nullptr != dst_batch)
+    {
+        gather_group_data(group, dst_batch->append(group.head.group_bytes));
+    }
+    else
+    {
+        gather_group_data(group, acquire_frame(groups, group.head.group_bytes, dst_list).data());
+    }
+    return 1;
+}
+
+static void send_group_nack(groups_t & groups, const group_t & group)
+{
+    const group_head_t & group_head = group.head;
+    const group_body_t & group_body = group.body;
+
+    std::vector<uint8_t> nack_buffer;
+    nack_buffer.reserve(s_max_nack_bytes);
+
+    uint32_t block_index = 0;
+    while (block_index < group_head.need_block_count)
+    {
+        nack_buffer.assign(sizeof(nack_t), 0x0);
+        uint16_t range_count = 0;
+
+        while (block_index < group_head.need_block_count && nack_buffer.size() + sizeof(nack_range_t) <= s_max_nack_bytes)
+        {
+            while (block_index < group_head.need_block_count && (group_body.seq_block_bitmap[block_index >> 3] & (1 << (block_index & 7))))
+            {
+                ++block_index;
+            }
+
+            if (block_index == group_head.need_block_count)
+            {
+                break;
+            }
+
+            nack_range_t nack_range = { 0x0 };
+            nack_range.block_index = block_index;
+            while (block_index < group_head.need_block_count && !(group_body.seq_block_bitmap[block_index >> 3] & (1 << (block_index & 7))))
+            {
+                ++block_index;
+            }
+            nack_range.block_count = block_index - nack_range.block_index;
+            groups.nack_blocks += nack_range.block_count;
+            nack_range.encode();
+
+            const uint8_t * range_data = reinterpret_cast<const uint8_t *>(&nack_range);
+            nack_buffer.insert(nack_buffer.end(), range_data, range_data + sizeof(nack_range));
+            ++range_count;
+        }
+
+        if (0 == range_count)
+        {
+            break;
+        }
+
+        nack_t nack = { 0x0 };
+        nack.group_index = group_head.group_index;
+        nack.protocol_id = s_protocol_nack;
+        nack.range_count = range_count;
+        nack.block_count = group_head.need_block_count;
+        nack.encode();
+        memcpy(&nack_buffer[0], &nack, sizeof(nack));
+
+        (*groups.nack_callback)(groups.nack_user_data, &nack_buffer[0], static_cast<uint32_t>(nack_buffer.size()));
+        groups.nack_messages += 1;
+    }
+}
+
+static void send_nacks(groups_t & groups)
+{
+    if (nullptr == groups.nack_callback || 0 == groups.nack_delay_microseconds || 0 == groups.next_nack_time)
+    {
+        return;
+    }
+
+    const uint64_t current_time = groups.current_time;
+    if (current_time < groups.next_nack_time)
+    {
+        return;
+    }
+
+    groups.next_nack_time = 0;
+    for (std::map<uint64_t, group_t>::iterator iter = groups.group_items.begin(); groups.group_items.end() != iter; ++iter)
+    {
+        group_t & group = iter->second;
+        group_head_t & group_head = group.head;
+        if (0 == group_head.nack_time || group_head.recv_block_count == group_head.need_block_count)
+        {
+            continue;
+        }
+
+        if (group_head.nack_time <= current_time && groups.lazy_recovery)
+        {
+            recover_lazy_group(groups, group);
+            if (group_head.recv_block_count == group_head.need_block_count)
+            {
+                continue;
+            }
+        }
+
+        if (group_head.nack_time <= current_time)
+        {
+            send_group_nack(groups, group);
+            group_head.nack_time = current_time + groups.nack_delay_microseconds;
+        }
+
+        if (0 == groups.next_nack_time || group_head.nack_time < groups.next_nack_time)
+        {
+            groups.next_nack_time = group_head.nack_time;
+        }
+    }
+}
+
+static bool packet_resend(const uint8_t * nack_data, uint32_t nack_size, const retransmit_cache_t & retransmit_cache, PacketBatch & dst_batch)
+{
+    if (nullptr == nack_data || nack_size < sizeof(nack_t))
+    {
+        return false;
+    }
+
+    nack_t nack = *reinterpret_cast<const nack_t *>(nack_data);
+    nack.decode();
+
+    if (s_protocol_nack != nack.protocol_id || sizeof(nack_t) + static_cast<uint64_t>(nack.range_count) * sizeof(nack_range_t) > nack_size)
+    {
+        return false;
+    }
+
+    std::size_t resend_count = 0;
+    for (uint16_t range_index = 0; range_index < nack.range_count; ++range_index)
+    {
+        nack_range_t nack_range = *reinterpret_cast<const nack_range_t *>(nack_data + sizeof(nack_t) + range_index * sizeof(nack_range_t));
+        nack_range.decode();
+
+        const uint64_t end_block_index = static_cast<uint64_t>(nack_range.block_index) + nack_range.block_count;
+        for (std::size_t position = find_cached_block(retransmit_cache, nack.group_index, nack_range.block_index); position < retransmit_cache.slot_count; ++position)
+        {
+            const retransmit_slot_t & slot = cached_block(retransmit_cache, position);
+            if (slot.group_index != nack.group_index || slot.block_index >= end_block_index)
+            {
+                break;
+            }
+
+            dst_batch.append(&slot.block_data[0], static_cast<uint32_t>(slot.block_data.size()));
+            ++resend_count;
+        }
+    }
+
+    return resend_count > 0;
+}
+
+static uint64_t lap_nanoseconds(uint64_t & stage_time)
+{
+    const uint64_t current_time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    const uint64_t elapsed_time = current_time - stage_time;
+    stage_time = current_time;
+    return elapsed_time;
+}
+
+static void flush_trace_output(trace_output_t & output)
+{
+    if (nullptr != output.file && !output.buffer.empty())
+    {
+        fwrite(output.buffer.data(), 1, output.buffer.size(), output.file);
+        output.buffer.clear();
+    }
+}
+
+static void close_trace_output(trace_output_t & output)
+{
+    flush_trace_output(output);
+    if (nullptr != output.file)
+    {
+        fclose(output.file);
+        output.file = nullptr;
+    }
+}
+
+static void trace_datagram(groups_t & groups, const void * data, uint32_t size)
+{
+    trace_output_t & output = groups.trace_output;
+    if (nullptr == output.file || groups.replaying)
+    {
+        return;
+    }
+
+    const uint8_t * datagram = reinterpret_cast<const uint8_t *>(data);
+    const uint32_t datagram_bytes = (nullptr != datagram ? size : 0);
+    uint32_t captured_bytes = datagram_bytes;
+    if (!output.with_payload && datagram_bytes >= sizeof(block_t))
+    {
+        captured_bytes = std::min<uint32_t>(datagram_bytes, block_head_size(0 != (reinterpret_cast<const block_t *>(datagram)->protocol_id & s_protocol_ext)));
+    }
+
+    trace_record_t trace_record = { 0x0 };
+    trace_record.timestamp = groups.current_time;
+    trace_record.datagram_bytes = datagram_bytes;
+    trace_record.captured_bytes = captured_bytes;
+    trace_record.encode();
+
+    const uint8_t * record_data = reinterpret_cast<const uint8_t *>(&trace_record);
+    output.buffer.insert(output.buffer.end(), record_data, record_data + sizeof(trace_record));
+    output.buffer.insert(output.buffer.end(), datagram, datagram + captured_bytes);
+    if (output.buffer.size() >= s_trace_buffer_bytes)
+    {
+        flush_trace_output(output);
+    }
+}
+
+static bool unwrap_path_block(const void *& data, uint32_t & size, groups_t & groups)
+{
+    if (nullptr == data || size < sizeof(path_head_t) || s_protocol_path != reinterpret_cast<const path_head_t *>(data)->protocol_id)
+    {
+        return true;
+    }
+
+    path_head_t path_head = *reinterpret_cast<const path_head_t *>(data);
+    path_head.decode();
+    if (path_head.path_index >= s_max_path_count || sizeof(path_head) == size)
+    {
+        return false;
+    }
+
+    path_state_t & path_state = groups.path_states[path_head.path_index];
+    if (!path_state.active)
+    {
+        path_state.active = true;
+        path_state.first_sequence = path_head.path_sequence;
+        path_state.max_sequence = path_head.path_sequence;
+    }
+    path_state.first_sequence = std::min<uint64_t>(path_state.first_sequence, path_head.path_sequence);
+    path_state.max_sequence = std::max<uint64_t>(path_state.max_sequence, path_head.path_sequence);
+    path_state.received_blocks += 1;
+    path_state.received_bytes += size;
+
+    const uint32_t clock_offset = static_cast<uint32_t>(groups.current_time) - path_head.send_time;
+    if (!groups.path_clock_valid)
+    {
+        groups.path_clock_valid = true;
+        groups.path_clock_offset = clock_offset;
+    }
+    const double delay = static_cast<int32_t>(clock_offset - groups.path_clock_offset);
+    if (!path_state.delay_valid)
+    {
+        path_state.delay_valid = true;
+        path_state.delay_average = delay;
+    }
+    else
+    {
+        estimator_sample(path_state.delay_valid, path_state.delay_average, path_state.delay_deviation, delay);
+    }
+
+    data = reinterpret_cast<const uint8_t *>(data) + sizeof(path_head);
+    size -= sizeof(path_head);
+
+    return true;
+}
+
+static bool unify_block(const void * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    if (nullptr == data || 0 == size)
+    {
+        return true;
+    }
+
+    if (size >= sizeof(block_t) && s_protocol_parity == (reinterpret_cast<const block_t *>(data)->protocol_id & ~s_protocol_ext))
+    {
+        return insert_parity_block(data, size, groups, max_delay_microseconds);
+    }
+
+    if (!insert_group_block(data, size, groups, max_delay_microseconds))
+    {
+        return false;
+    }
+
+    remember_parity_block(reinterpret_cast<const uint8_t *>(data), size, groups, max_delay_microseconds);
+
+    advance_progress(groups);
+
+    group_t & group = groups.group_items[groups.new_group_index];
+    return group.head.recv_block_count == group.head.need_block_count || groups.new_group_index != groups.min_group_index;
+}
+
+static void xor_stream_symbol(std::vector<uint8_t> & payload, const std::vector<uint8_t> & symbol)
+{
+    const std::size_t symbol_bytes = s_stream_symbol_head_bytes + symbol.size();
+    if (payload.size() < symbol_bytes)
+    {
+        payload.resize(symbol_bytes, 0x0);
+    }
+    payload[0] ^= static_cast<uint8_t>(symbol.size() >> 8);
+    payload[1] ^= static_cast<uint8_t>(symbol.size() & 0xFF);
+    if (!symbol.empty())
+    {
+        fill_xor_data(&payload[s_stream_symbol_head_bytes], &payload[s_stream_symbol_head_bytes], &symbol[0], static_cast<uint32_t>(symbol.size()));
+    }
+}
+
+static void xor_stream_equation(stream_equation_t & equation, const stream_equation_t & other)
+{
+    std::vector<uint64_t> unknowns;
+    std::set_symmetric_difference(equation.unknowns.begin(), equation.unknowns.end(), other.unknowns.begin(), other.unknowns.end(), std::back_inserter(unknowns));
+    equation.unknowns.swap(unknowns);
+    if (equation.payload.size() < other.payload.size())
+    {
+        equation.payload.resize(other.payload.size(), 0x0);
+    }
+    fill_xor_data(&equation.payload[0], &equation.payload[0], &other.payload[0], static_cast<uint32_t>(other.payload.size()));
+}
+
+static void insert_stream_equation(stream_decoder_t & decoder, stream_equation_t & equation, std::list<uint64_t> & solved_sequences)
+{
+    std::vector<uint64_t>::iterator unknown_iter = equation.unknowns.begin();
+    while (equation.unknowns.end() != unknown_iter)
+    {
+        std::map<uint64_t, std::vector<uint8_t>>::const_iterator symbol_iter = decoder.symbols.find(*unknown_iter);
+        if (decoder.symbols.end() != symbol_iter)
+        {
+            xor_stream_symbol(equation.payload, symbol_iter->second);
+            unknown_iter = equation.unknowns.erase(unknown_iter);
+        }
+        else
+        {
+            ++unknown_iter;
+        }
+    }
+
+    for (std::map<uint64_t, stream_equation_t>::const_iterator iter = decoder.equations.begin(); decoder.equations.end() != iter && !equation.unknowns.empty(); ++iter)
+    {
+        if (std::binary_search(equation.unknowns.begin(), equation.unknowns.end(), iter->first))
+        {
+            xor_stream_equation(equation, iter->second);
+        }
+    }
+
+    if (equation.unknowns.empty())
+    {
+        return;
+    }
+
+    const uint64_t pivot = equation.unknowns.front();
+    for (std::map<uint64_t, stream_equation_t>::iterator iter = decoder.equations.begin(); decoder.equations.end() != iter && iter->first < pivot; ++iter)
+    {
+        if (std::binary_search(iter->second.unknowns.begin(), iter->second.unknowns.end(), pivot))
+        {
+            xor_stream_equation(iter->second, equation);
+            if (1 == iter->second.unknowns.size())
+            {
+                solved_sequences.push_back(iter->first);
+            }
+        }
+    }
+
+    stream_equation_t & pivot_equation = decoder.equations[pivot];
+    pivot_equation.unknowns.swap(equation.unknowns);
+    pivot_equation.payload.swap(equation.payload);
+    if (1 == pivot_equation.unknowns.size())
+    {
+        solved_sequences.push_back(pivot);
+    }
+}
+
+static void learn_stream_symbol(stream_decoder_t & decoder, uint64_t sequence, std::list<uint64_t> & solved_sequences)
+{
+    const std::vector<uint8_t> & symbol = decoder.symbols[sequence];
+    std::list<stream_equation_t> orphan_equations;
+
+    std::map<uint64_t, stream_equation_t>::iterator iter = decoder.equations.begin();
+    while (decoder.equations.end() != iter && iter->first <= sequence)
+    {
+        std::vector<uint64_t> & unknowns = iter->second.unknowns;
+        std::vector<uint64_t>::iterator unknown_iter = std::lower_bound(unknowns.begin(), unknowns.end(), sequence);
+        if (unknowns.end() == unknown_iter || sequence != *unknown_iter)
+        {
+            ++iter;
+            continue;
+        }
+
+        xor_stream_symbol(iter->second.payload, symbol);
+        unknowns.erase(unknown_iter);
+        if (iter->first == sequence)
+        {
+            orphan_equations.emplace_back();
+            orphan_equations.back().unknowns.swap(unknowns);
+            orphan_equations.back().payload.swap(iter->second.payload);
+            iter = decoder.equations.erase(iter);
+            continue;
+        }
+
+        if (1 == unknowns.size())
+        {
+            solved_sequences.push_back(iter->first);
+        }
+        ++iter;
+    }
+
+    for (std::list<stream_equation_t>::iterator orphan_iter = orphan_equations.begin(); orphan_equations.end() != orphan_iter; ++orphan_iter)
+    {
+        insert_stream_equation(decoder, *orphan_iter, solved_sequences);
+    }
+}
+
+static void resolve_stream_equations(stream_decoder_t & decoder, std::list<uint64_t> & solved_sequences, std::vector<uint64_t> & recovered_sequences)
+{
+    while (!solved_sequences.empty())
+    {
+        const uint64_t sequence = solved_sequences.front();
+        solved_sequences.pop_front();
+
+        std::map<uint64_t, stream_equation_t>::iterator iter = decoder.equations.find(sequence);
+        if (decoder.equations.end() == iter || 1 != iter->second.unknowns.size())
+        {
+            continue;
+        }
+
+        const std::vector<uint8_t> & payload = iter->second.payload;
+        const uint32_t symbol_bytes = (payload.size() < s_stream_symbol_head_bytes ? 0 : ((static_cast<uint32_t>(payload[0]) << 8) | static_cast<uint32_t>(payload[1])));
+        if (0 == symbol_bytes || s_stream_symbol_head_bytes + symbol_bytes > payload.size())
+        {
+            decoder.equations.erase(iter);
+            continue;
+        }
+
+        decoder.symbols[sequence].assign(payload.begin() + s_stream_symbol_head_bytes, payload.begin() + s_stream_symbol_head_bytes + symbol_bytes);
+        recovered_sequences.push_back(sequence);
+        learn_stream_symbol(decoder, sequence, solved_sequences);
+    }
+}
+
+static void prune_stream_decoder(stream_decoder_t & decoder)
+{
+    if (decoder.max_sequence < s_stream_history_symbols)
+    {
+        return;
+    }
+
+    const uint64_t horizon = decoder.max_sequence - s_stream_history_symbols;
+    decoder.symbols.erase(decoder.symbols.begin(), decoder.symbols.lower_bound(horizon));
+    decoder.equations.erase(decoder.equations.begin(), decoder.equations.lower_bound(horizon));
+}
+
+static bool unify_stream_block(const void * data, uint32_t size, groups_t & groups, uint32_t max_delay_microseconds)
+{
+    if (nullptr == data || size <= sizeof(stream_head_t))
+    {
+        return unify_block(data, size, groups, max_delay_microseconds);
+    }
+
+    const uint8_t protocol_id = reinterpret_cast<const stream_head_t *>(data)->protocol_id;
+    if (s_protocol_stream != protocol_id && s_protocol_repair != protocol_id)
+    {
+        return unify_block(data, size, groups, max_delay_microseconds);
+    }
+
+    stream_decoder_t & decoder = groups.stream_decoder;
+    std::list<uint64_t> solved_sequences;
+    bool inserted = false;
+
+    if (s_protocol_stream == protocol_id)
+    {
+        stream_head_t stream_head = *reinterpret_cast<const stream_head_t *>(data);
+        stream_head.decode();
+        const uint8_t * block_data = reinterpret_cast<const uint8_t *>(data) + sizeof(stream_head);
+        const uint32_t block_size = static_cast<uint32_t>(size - sizeof(stream_head));
+
+        if (stream_head.source_sequence + s_stream_history_symbols > decoder.max_sequence && decoder.symbols.end() == decoder.symbols.find(stream_head.source_sequence))
+        {
+            decoder.max_sequence = std::max<uint64_t>(decoder.max_sequence, stream_head.source_sequence);
+            decoder.symbols[stream_head.source_sequence].assign(block_data, block_data + block_size);
+            learn_stream_symbol(decoder, stream_head.source_sequence, solved_sequences);
+        }
+
+        inserted = unify_block(block_data, block_size, groups, max_delay_microseconds);
+    }
+    else
+    {
+        stream_repair_t stream_repair = { 0x0 };
+        if (!parse_stream_repair(reinterpret_cast<const uint8_t *>(data), size, stream_repair))
+        {
+            return false;
+        }
+
+        if (stream_repair.window_end + s_stream_history_symbols <= decoder.max_sequence)
+        {
+            return false;
+        }
+        decoder.max_sequence = std::max<uint64_t>(decoder.max_sequence, stream_repair.window_end);
+
+        stream_equation_t equation;
+        for (uint32_t bit_index = stream_repair.window_size; bit_index > 0; --bit_index)
+        {
+            if (0 != ((stream_repair.coefficient_mask >> (bit_index - 1)) & 0x01))
+            {
+                equation.unknowns.push_back(stream_repair.window_end - (bit_index - 1));
+            }
+        }
+        equation.payload.assign(reinterpret_cast<const uint8_t *>(data) + sizeof(stream_repair), reinterpret_cast<const uint8_t *>(data) + size);
+        insert_stream_equation(decoder, equation, solved_sequences);
+    }
+
+    std::vector<uint64_t> recovered_sequences;
+    resolve_stream_equations(decoder, solved_sequences, recovered_sequences);
+
+    for (std::vector<uint64_t>::const_iterator iter = recovered_sequences.begin(); recovered_sequences.end() != iter; ++iter)
+    {
+        const std::vector<uint8_t> & symbol = decoder.symbols[*iter];
+        decoder.recovered_blocks += 1;
+        inserted = unify_block(&symbol[0], static_cast<uint32_t>(symbol.size()), groups, max_delay_microseconds) || inserted;
+    }
+
+    prune_stream_decoder(decoder);
+
+    return inserted;
+}
+
+static uint64_t next_unify_deadline(const groups_t & groups)
+{
+    uint64_t deadline = 0;
+
+    if (nullptr != groups.nack_callback && 0 != groups.nack_delay_microseconds && 0 != groups.next_nack_time)
+    {
+        deadline = groups.next_nack_time;
+    }
+
+    if (!groups.decode_timer_list.empty())
+    {
+        const decode_timer_t & decode_timer = groups.decode_timer_list.front();
+        std::map<uint64_t, group_t>::const_iterator group_iter = groups.group_items.find(decode_timer.group_index);
+        uint64_t decode_time = static_cast<uint64_t>(decode_timer.decode_seconds) * 1000000 + decode_timer.decode_microseconds + 1;
+        if (groups.group_items.end() != group_iter)
+        {
+            const group_t & group = group_iter->second;
+            const cross_parity_t & cross_parity = groups.cross_parity;
+            if (group.head.recv_block_count == group.head.need_block_count)
+            {
+                decode_time = ((cross_parity.active && 0 != cross_parity.gap_deadline && cross_parity.gap_group_index == groups.min_group_index) ? cross_parity.gap_deadline : groups.current_time);
+            }
+            else if (groups.lazy_recovery && !group.body.xor_blocks.empty())
+            {
+                decode_time = std::max<uint64_t>(decode_time, groups.lazy_margin_microseconds + 1) - groups.lazy_margin_microseconds - 1;
+            }
+        }
+        if (0 == deadline || decode_time < deadline)
+        {
+            deadline = decode_time;
+        }
+    }
+
+    return deadline;
+}
+
+static bool packet_unify(const void * data, uint32_t size, groups_t & groups, uint64_t current_time, std::list<std::vector<uint8_t>> & dst_list, PacketBatch * dst_batch, uint32_t max_delay_microseconds, double fault_tolerance_rate, reserve_callback_t reserve_callback, decode_callback_t decode_callback, void * user_data)
+{
+    groups.current_time = current_time;
+    trace_datagram(groups, data, size);
+
+    if (!unwrap_path_block(data, size, groups))
+    {
+        return false;
+    }
+
+    PACKET_XOR_PROBE2(unify__begin, size, groups.current_time);
+
+    replay_stats_t * replay_stats = groups.replay_stats;
+    uint64_t stage_time = 0;
+    if (nullptr != replay_stats)
+    {
+        lap_nanoseconds(stage_time);
+    }
+
+    send_nacks(groups);
+
+    if (nullptr != replay_stats)
+    {
+        replay_stats->nack_nanoseconds += lap_nanoseconds(stage_time);
+    }
+
+    const bool inserted = unify_stream_block(data, size, groups, max_delay_microseconds);
+
+    if (nullptr != replay_stats)
+    {
+        replay_stats->insert_nanoseconds += lap_nanoseconds(stage_time);
+    }
+
+    if (!inserted)
+    {
+        PACKET_XOR_PROBE2(unify__end, 0, groups.current_time);
+        return false;
+    }
+
+    std::size_t deliver_count = 0;
+
+    const uint32_t current_seconds = static_cast<uint32_t>(groups.current_time / 1000000);
+    const uint32_t current_microseconds = static_cast<uint32_t>(groups.current_time % 1000000);
+    std::list<decode_timer_t>::iterator iter = groups.decode_timer_list.begin();
+    while (groups.decode_timer_list.end() != iter)
+    {
+        const decode_timer_t & decode_timer = *iter;
+        group_t & group = groups.group_items[decode_timer.group_index];
+        if (groups.lazy_recovery && group.head.recv_block_count < group.head.need_block_count && !group.body.xor_blocks.empty())
+        {
+            const uint64_t decode_time = static_cast<uint64_t>(decode_timer.decode_seconds) * 1000000 + decode_timer.decode_microseconds;
+            if (decode_time <= groups.current_time + groups.lazy_margin_microseconds)
+            {
+                recover_lazy_group(groups, group);
+            }
+        }
+        if (group.head.recv_block_count == group.head.need_block_count)
+        {
+            if (wait_parity_gap(groups, decode_timer.group_index, max_delay_microseconds))
+            {
+                break;
+            }
+            if (groups.expire_estimator.enabled && group.head.need_block_count > 1)
+            {
+                expire_estimator_t & estimator = groups.expire_estimator;
+                estimator_sample(estimator.spread_valid, estimator.spread_average, estimator.spread_deviation, static_cast<double>(group.head.last_time - group.head.first_time) / (group.head.need_block_count - 1));
+            }
+            deliver_count += deliver_group(groups, group, dst_list, dst_batch, reserve_callback, decode_callback, user_data);
+            remove_group(groups, decode_timer.group_index);
+            groups.min_group_index = decode_timer.group_index + 1;
+            iter = groups.decode_timer_list.erase(iter);
+        }
+        else if ((decode_timer.decode_seconds < current_seconds) || (decode_timer.decode_seconds == current_seconds && decode_timer.decode_microseconds < current_microseconds))
+        {
+            PACKET_XOR_PROBE5(group__expired, decode_timer.group_index, group.head.recv_block_count, group.head.need_block_count, group.head.first_time, groups.current_time);
+            if (fault_tolerance_rate > 0.0 && fault_tolerance_rate < 1.0)
+            {
+                if (group.head.recv_block_count >= static_cast<uint32_t>(group.head.need_block_count * (1.0 - fault_tolerance_rate)))
+                {
+                    deliver_count += deliver_group(groups, group, dst_list, dst_batch, reserve_callback, decode_callback, user_data);
+                }
+            }
+            remove_group(groups, decode_timer.group_index);
+            groups.min_group_index = decode_timer.group_index + 1;
+            iter = groups.decode_timer_list.erase(iter);
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    remove_expired_blocks(groups);
+
+    advance_progress(groups);
+
+    if (nullptr != replay_stats)
+    {
+        replay_stats->deliver_nanoseconds += lap_nanoseconds(stage_time);
+    }
+
+    PACKET_XOR_PROBE2(unify__end, deliver_count, groups.current_time);
+
+    return deliver_count > 0;
+}
+
+static bool read_object_data(int file_descriptor, uint64_t object_offset, uint8_t * data, uint32_t size)
+{
+#ifdef _MSC_VER
+    if (_lseeki64(file_descriptor, static_cast<__int64>(object_offset), SEEK_SET) < 0)
+    {
+        return false;
+    }
+#endif // _MSC_VER
+
+    while (0 != size)
+    {
+#ifdef _MSC_VER
+        const int read_bytes = _read(file_descriptor, data, size);
+#else
+        const ssize_t read_bytes = pread(file_descriptor, data, size, static_cast<off_t>(object_offset));
+        if (read_bytes < 0 && EINTR == errno)
+        {
+            continue;
+        }
+#endif // _MSC_VER
+        if (read_bytes <= 0)
+        {
+            return false;
+        }
+        data += read_bytes;
+        size -= static_cast<uint32_t>(read_bytes);
+        object_offset += static_cast<uint64_t>(read_bytes);
+    }
+
+    return true;
+}
+
+class PacketXorDividerImpl
+{
+public:
+    PacketXorDividerImpl(uint32_t max_block_size, bool use_xor, bool use_crc);
+    PacketXorDividerImpl(const PacketXorDividerImpl &) = delete;
+    PacketXorDividerImpl(PacketXorDividerImpl &&) = delete;
+    PacketXorDividerImpl & operator = (const PacketXorDividerImpl &) = delete;
+    PacketXorDividerImpl & operator = (PacketXorDividerImpl &&) = delete;
+    ~PacketXorDividerImpl();
+
+public:
+    bool encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
+    bool encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data);
+    bool encode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch);
+
+public:
+    bool set_aggregation(uint32_t max_message_size, uint32_t max_delay_microseconds);
+    bool poll(std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data);
+    bool poll(PacketBatch & dst_batch);
+    bool flush(std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data);
+    bool flush(PacketBatch & dst_batch);
+
+public:
+    bool set_retransmit(uint32_t cache_block_count);
+    bool resend(const uint8_t * nack_data, uint32_t nack_size, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data);
+    bool resend(const uint8_t * nack_data, uint32_t nack_size, PacketBatch & dst_batch);
+
+public:
+    bool set_cross_parity(uint32_t window_groups, uint32_t max_delay_microseconds);
+    bool set_stream_fec(uint32_t window_blocks, uint32_t repair_interval);
+
+public:
+    bool set_send_queue(uint64_t max_queue_bytes, uint32_t max_queue_microseconds, uint32_t frame_deadline_microseconds);
+    bool enqueue(const uint8_t * src_data, uint32_t src_size, int32_t frame_class);
+    bool send(send_callback_t send_callback, void * user_data);
+    void get_send_stats(sender_stats_t & stats) const;
+
+public:
+    bool set_frame_class(uint8_t frame_class, uint32_t xor_stride, uint32_t deadline_millisecond);
+    bool encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data);
+    bool encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, PacketBatch & dst_batch);
+
+public:
+    bool encode_object(const uint8_t * object_data, int file_descriptor, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data);
+
+public:
+    void reset();
+
+private:
+    bool encode_frame(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch);
+    bool divide_frame(const uint8_t * src_data, uint32_t src_size, uint32_t xor_stride, block_ext_t block_ext, PacketBatch & dst_batch);
+    bool flush_aggregate(PacketBatch & dst_batch);
+    bool flush_parity(PacketBatch & dst_batch);
+    void flush_stream(PacketBatch & dst_batch);
+    void append_stream_repair(PacketBatch & dst_batch);
+    bool emit_batch(bool ret, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data);
+    block_ext_t make_block_ext(uint8_t ext_flags) const;
+    void drop_stale_frames(uint64_t current_time);
+    void drop_send_frame(std::list<send_frame_t>::iterator iter);
+
+private:
+    const uint32_t      m_max_block_size;
+    const bool          m_use_xor;
+    const bool          m_use_crc;
+
+private:
+    uint64_t            m_group_index;
+
+private:
+    uint32_t            m_aggregate_message_size;
+    uint32_t            m_aggregate_delay_microseconds;
+    uint64_t            m_aggregate_deadline;
+    std::vector<uint8_t> m_aggregate_data;
+
+private:
+    retransmit_cache_t  m_retransmit_cache;
+
+private:
+    frame_class_t       m_frame_classes[s_max_frame_class];
+
+private:
+    uint32_t            m_object_id;
+    std::vector<uint8_t> m_object_buffer;
+
+private:
+    uint32_t            m_parity_window;
+    uint32_t            m_parity_delay_microseconds;
+    uint64_t            m_parity_deadline;
+    uint64_t            m_parity_group_index;
+    uint32_t            m_parity_group_count;
+    std::vector<uint8_t> m_parity_data;
+
+private:
+    uint32_t            m_stream_window;
+    uint32_t            m_stream_interval;
+    uint64_t            m_stream_sequence;
+    uint32_t            m_stream_pending;
+    std::list<std::vector<uint8_t>> m_stream_symbols;
+    PacketBatch         m_stream_batch;
+
+private:
+    bool                m_send_queue_enabled;
+    uint64_t            m_max_queue_bytes;
+    uint32_t            m_max_queue_microseconds;
+    uint32_t            m_frame_deadline_microseconds;
+    std::list<send_frame_t> m_send_frames;
+    std::list<send_frame_t> m_free_send_frames;
+    PacketBatch         m_send_batch;
+    std::size_t         m_send_index;
+    sender_stats_t      m_send_stats;
+
+private:
+    PacketBatch         m_block_batch;
+};
+
+PacketXorDividerImpl::PacketXorDividerImpl(uint32_t max_block_size, bool use_xor, bool use_crc)
+    : m_max_block_size(std::max<uint32_t>(max_block_size, block_head_size(use_crc) + 1))
+    , m_use_xor(use_xor)
+    , m_use_crc(use_crc)
+    , m_group_index(0)
+    , m_aggregate_message_size(0)
+    , m_aggregate_delay_microseconds(0)
+    , m_aggregate_deadline(0)
+    , m_aggregate_data()
+    , m_retransmit_cache()
+    , m_object_id(0)
+    , m_object_buffer()
+    , m_parity_window(0)
+    , m_parity_delay_microseconds(0)
+    , m_parity_deadline(0)
+    , m_parity_group_index(0)
+    , m_parity_group_count(0)
+    , m_parity_data()
+    , m_stream_window(0)
+    , m_stream_interval(0)
+    , m_stream_sequence(0)
+    , m_stream_pending(0)
+    , m_stream_symbols()
+    , m_stream_batch()
+    , m_send_queue_enabled(false)
+    , m_max_queue_bytes(0)
+    , m_max_queue_microseconds(0)
+    , m_frame_deadline_microseconds(0)
+    , m_send_frames()
+    , m_free_send_frames()
+    , m_send_batch()
+    , m_send_index(0)
+    , m_block_batch()
+{
+    for (uint32_t index = 0; index < s_max_frame_class; ++index)
+    {
+        m_frame_classes[index].xor_stride = (m_use_xor ? 1 : 0);
+        m_frame_classes[index].deadline_millisecond = 0;
+    }
+
+    memset(&m_send_stats, 0x0, sizeof(m_send_stats));
+
+}
+
+PacketXorDividerImpl::~PacketXorDividerImpl()
+{
+
+}
+
+bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return emit_batch(encode_frame(src_data, src_size, m_block_batch), dst_list, nullptr, nullptr);
+}
+
+bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return emit_batch(encode_frame(src_data, src_size, m_block_batch), dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch)
+{
+    return encode_frame(src_data, src_size, dst_batch);
+}
+
+bool PacketXorDividerImpl::set_aggregation(uint32_t max_message_size, uint32_t max_delay_microseconds)
+{
+    const uint32_t head_size = block_head_size(true) + s_aggregate_record_head_bytes;
+    if (0 != max_message_size && (m_max_block_size <= head_size || max_message_size > std::min<uint32_t>(m_max_block_size - head_size, 0xFFFF)))
+    {
+        return false;
+    }
+
+    m_aggregate_message_size = max_message_size;
+    m_aggregate_delay_microseconds = max_delay_microseconds;
+
+    return true;
+}
+
+bool PacketXorDividerImpl::poll(std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+{
+    return emit_batch(poll(m_block_batch), dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDividerImpl::poll(PacketBatch & dst_batch)
+{
+    const uint64_t current_time = get_steady_microseconds();
+    const bool aggregated = (!m_aggregate_data.empty() && current_time >= m_aggregate_deadline && flush_aggregate(dst_batch));
+    const bool parity_sent = (0 != m_parity_group_count && current_time >= m_parity_deadline && flush_parity(dst_batch));
+    return aggregated || parity_sent;
+}
+
+bool PacketXorDividerImpl::flush(std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+{
+    return emit_batch(flush(m_block_batch), dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDividerImpl::flush(PacketBatch & dst_batch)
+{
+    const bool aggregated = flush_aggregate(dst_batch);
+    const bool parity_sent = flush_parity(dst_batch);
+    return aggregated || parity_sent;
+}
+
+bool PacketXorDividerImpl::flush_aggregate(PacketBatch & dst_batch)
+{
+    if (m_aggregate_data.empty())
+    {
+        return false;
+    }
+
+    const bool ret = divide_frame(&m_aggregate_data[0], static_cast<uint32_t>(m_aggregate_data.size()), (m_use_xor ? 1 : 0), make_block_ext(s_ext_flag_aggregate), dst_batch);
+    m_aggregate_data.clear();
+
+    return ret;
+}
+
+bool PacketXorDividerImpl::divide_frame(const uint8_t * src_data, uint32_t src_size, uint32_t xor_stride, block_ext_t block_ext, PacketBatch & dst_batch)
+{
+    if (0 != m_stream_window && &dst_batch != &m_stream_batch)
+    {
+        const bool ret = divide_frame(src_data, src_size, xor_stride, block_ext, m_stream_batch);
+        flush_stream(dst_batch);
+        return ret;
+    }
+
+    const uint32_t head_size = block_head_size(0 != block_ext.ext_flags);
+    if (0 == m_parity_window || 0 == xor_stride || nullptr == src_data || 0 == src_size || static_cast<uint64_t>(head_size) + src_size > m_max_block_size)
+    {
+        flush_parity(dst_batch);
+        return packet_divide(src_data, src_size, m_max_block_size, xor_stride, block_ext, m_group_index, &m_retransmit_cache, dst_batch);
+    }
+
+    const std::size_t packet_index = dst_batch.size();
+    if (!packet_divide(src_data, src_size, m_max_block_size, 0, block_ext, m_group_index, &m_retransmit_cache, dst_batch))
+    {
+        return false;
+    }
+
+    const uint8_t * packet_data = dst_batch.data(packet_index);
+    const uint32_t packet_length = dst_batch.length(packet_index);
+    if (0 == m_parity_group_count)
+    {
+        m_parity_group_index = m_group_index - 1;
+        m_parity_deadline = get_steady_microseconds() + m_parity_delay_microseconds;
+        m_parity_data.assign(packet_data, packet_data + packet_length);
+    }
+    else
+    {
+        if (m_parity_data.size() < packet_length)
+        {
+            m_parity_data.resize(packet_length, 0x0);
+        }
+        fill_xor_data(&m_parity_data[0], &m_parity_data[0], packet_data, packet_length);
+    }
+
+    if (++m_parity_group_count == m_parity_window)
+    {
+        flush_parity(dst_batch);
+    }
+
+    return true;
+}
+
+bool PacketXorDividerImpl::flush_parity(PacketBatch & dst_batch)
+{
+    if (0 == m_parity_group_count)
+    {
+        return false;
+    }
+
+    if (0 != m_stream_window && &dst_batch != &m_stream_batch)
+    {
+        const bool ret = flush_parity(m_stream_batch);
+        flush_stream(dst_batch);
+        return ret;
+    }
+
+    if (1 == m_parity_group_count)
+    {
+        dst_batch.append(&m_parity_data[0], static_cast<uint32_t>(m_parity_data.size()));
+        m_parity_group_count = 0;
+        return true;
+    }
+
+    block_ext_t block_ext = make_block_ext(0x0);
+    const bool use_ext = (0 != block_ext.ext_flags);
+    const uint32_t head_size = block_head_size(use_ext);
+    const uint32_t parity_bytes = static_cast<uint32_t>(m_parity_data.size());
+
+    block_t parity_block = { 0x0 };
+    parity_block.group_index = m_parity_group_index;
+    parity_block.protocol_id = (use_ext ? (s_protocol_parity | s_protocol_ext) : s_protocol_parity);
+    parity_block.block_count = m_parity_group_count;
+    parity_block.block_bytes = parity_bytes;
+    parity_block.encode();
+    block_ext.encode();
+
+    uint8_t * parity_buffer = dst_batch.append(head_size + parity_bytes);
+    memcpy(parity_buffer, &parity_block, sizeof(parity_block));
+    if (use_ext)
+    {
+        memcpy(parity_buffer + sizeof(parity_block), &block_ext, sizeof(block_ext));
+        seal_block_checksum(parity_buffer, crc32c_copy(crc32c_update(0, parity_buffer, head_size), parity_buffer + head_size, &m_parity_data[0], parity_bytes));
+    }
+    else
+    {
+        memcpy(parity_buffer + head_size, &m_parity_data[0], parity_bytes);
+    }
+
+    m_parity_group_count = 0;
+
+    return true;
+}
+
+static uint64_t stream_coefficient_mask(uint64_t window_end, uint32_t window_size)
+{
+    uint64_t mask = window_end * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+    mask = (mask ^ (mask >> 33)) * 0xFF51AFD7ED558CCDULL;
+    mask = (mask ^ (mask >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+    mask = mask ^ (mask >> 33);
+    return (window_size >= 64 ? mask : (mask & ((1ULL << window_size) - 1))) | 0x01;
+}
+
+void PacketXorDividerImpl::flush_stream(PacketBatch & dst_batch)
+{
+    for (std::size_t packet_index = 0; packet_index < m_stream_batch.size(); ++packet_index)
+    {
+        const uint8_t * packet_data = m_stream_batch.data(packet_index);
+        const uint32_t packet_length = m_stream_batch.length(packet_index);
+
+        stream_head_t stream_head = { 0x0 };
+        stream_head.source_sequence = m_stream_sequence++;
+        stream_head.protocol_id = s_protocol_stream;
+        stream_head.encode();
+
+        uint8_t * stream_buffer = dst_batch.append(sizeof(stream_head) + packet_length);
+        memcpy(stream_buffer, &stream_head, sizeof(stream_head));
+        memcpy(stream_buffer + sizeof(stream_head), packet_data, packet_length);
+
+        if (m_stream_symbols.size() < m_stream_window)
+        {
+            m_stream_symbols.emplace_back();
+        }
+        else
+        {
+            m_stream_symbols.splice(m_stream_symbols.end(), m_stream_symbols, m_stream_symbols.begin());
+        }
+        m_stream_symbols.back().assign(packet_data, packet_data + packet_length);
+
+        if (++m_stream_pending == m_stream_interval)
+        {
+            m_stream_pending = 0;
+            append_stream_repair(dst_batch);
+        }
+    }
+
+    m_stream_batch.clear();
+}
+
+void PacketXorDividerImpl::append_stream_repair(PacketBatch & dst_batch)
+{
+    const uint32_t window_size = static_cast<uint32_t>(m_stream_symbols.size());
+    const uint64_t window_end = m_stream_sequence - 1;
+    const uint64_t coefficient_mask = stream_coefficient_mask(window_end, window_size);
+
+    uint32_t repair_bytes = 0;
+    uint32_t bit_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_reverse_iterator iter = m_stream_symbols.rbegin(); m_stream_symbols.rend() != iter; ++iter, ++bit_index)
+    {
+        if (0 != ((coefficient_mask >> bit_index) & 0x01))
+        {
+            repair_bytes = std::max<uint32_t>(repair_bytes, static_cast<uint32_t>(s_stream_symbol_head_bytes + iter->size()));
+        }
+    }
+
+    stream_repair_t stream_repair = { 0x0 };
+    stream_repair.window_end = window_end;
+    stream_repair.protocol_id = s_protocol_repair;
+    stream_repair.window_size = static_cast<uint8_t>(window_size);
+    stream_repair.repair_bytes = static_cast<uint16_t>(repair_bytes);
+    stream_repair.coefficient_mask = coefficient_mask;
+    stream_repair.encode();
+
+    uint8_t * repair_buffer = dst_batch.append(sizeof(stream_repair) + repair_bytes);
+    memcpy(repair_buffer, &stream_repair, sizeof(stream_repair));
+    uint8_t * repair_data = repair_buffer + sizeof(stream_repair);
+    memset(repair_data, 0x0, repair_bytes);
+
+    bit_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_reverse_iterator iter = m_stream_symbols.rbegin(); m_stream_symbols.rend() != iter; ++iter, ++bit_index)
+    {
+        if (0 != ((coefficient_mask >> bit_index) & 0x01))
+        {
+            repair_data[0] ^= static_cast<uint8_t>(iter->size() >> 8);
+            repair_data[1] ^= static_cast<uint8_t>(iter->size() & 0xFF);
+            fill_xor_data(repair_data + s_stream_symbol_head_bytes, repair_data + s_stream_symbol_head_bytes, &(*iter)[0], static_cast<uint32_t>(iter->size()));
+        }
+    }
+}
+
+bool PacketXorDividerImpl::encode_frame(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch)
+{
+    if (nullptr == src_data || 0 == src_size)
+    {
+        return false;
+    }
+
+    if (src_size > m_aggregate_message_size)
+    {
+        flush_aggregate(dst_batch);
+        return divide_frame(src_data, src_size, (m_use_xor ? 1 : 0), make_block_ext(0x0), dst_batch);
+    }
+
+    const uint32_t max_aggregate_bytes = m_max_block_size - block_head_size(true);
+    if (m_aggregate_data.size() + s_aggregate_record_head_bytes + src_size > max_aggregate_bytes)
+    {
+        flush_aggregate(dst_batch);
+    }
+
+    if (m_aggregate_data.empty())
+    {
+        m_aggregate_data.reserve(max_aggregate_bytes);
+        m_aggregate_deadline = get_steady_microseconds() + m_aggregate_delay_microseconds;
+    }
+
+    m_aggregate_data.push_back(static_cast<uint8_t>(src_size >> 8));
+    m_aggregate_data.push_back(static_cast<uint8_t>(src_size & 0xFF));
+    m_aggregate_data.insert(m_aggregate_data.end(), src_data, src_data + src_size);
+
+    if (m_aggregate_data.size() + s_aggregate_record_head_bytes >= max_aggregate_bytes)
+    {
+        flush_aggregate(dst_batch);
+    }
+    else
+    {
+        poll(dst_batch);
+    }
+
+    return true;
+}
+
+bool PacketXorDividerImpl::set_retransmit(uint32_t cache_block_count)
+{
+    m_retransmit_cache.slots.clear();
+    m_retransmit_cache.slots.resize(cache_block_count);
+    m_retransmit_cache.reset();
+    return true;
+}
+
+bool PacketXorDividerImpl::resend(const uint8_t * nack_data, uint32_t nack_size, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+{
+    return emit_batch(resend(nack_data, nack_size, m_block_batch), dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDividerImpl::resend(const uint8_t * nack_data, uint32_t nack_size, PacketBatch & dst_batch)
+{
+    return packet_resend(nack_data, nack_size, m_retransmit_cache, dst_batch);
+}
+
+bool PacketXorDividerImpl::set_cross_parity(uint32_t window_groups, uint32_t max_delay_microseconds)
+{
+    if (1 == window_groups || window_groups > s_max_parity_window)
+    {
+        return false;
+    }
+
+    m_parity_window = window_groups;
+    m_parity_delay_microseconds = max_delay_microseconds;
+    m_parity_group_count = 0;
+
+    return true;
+}
+
+bool PacketXorDividerImpl::set_stream_fec(uint32_t window_blocks, uint32_t repair_interval)
+{
+    if (0 != window_blocks && (window_blocks > s_max_stream_window || 0 == repair_interval || static_cast<uint64_t>(m_max_block_size) + s_stream_symbol_head_bytes > 0xFFFF))
+    {
+        return false;
+    }
+
+    m_stream_window = window_blocks;
+    m_stream_interval = repair_interval;
+    m_stream_pending = 0;
+    m_stream_symbols.clear();
+
+    return true;
+}
+
+bool PacketXorDividerImpl::set_send_queue(uint64_t max_queue_bytes, uint32_t max_queue_microseconds, uint32_t frame_deadline_microseconds)
+{
+    m_send_queue_enabled = true;
+    m_max_queue_bytes = max_queue_bytes;
+    m_max_queue_microseconds = max_queue_microseconds;
+    m_frame_deadline_microseconds = frame_deadline_microseconds;
+    return true;
+}
+
+void PacketXorDividerImpl::drop_send_frame(std::list<send_frame_t>::iterator iter)
+{
+    const uint64_t frame_bytes = iter->frame_data.size();
+    m_send_stats.queued_frames -= 1;
+    m_send_stats.queued_bytes -= frame_bytes;
+    m_send_stats.dropped_frames += 1;
+    m_send_stats.dropped_bytes += frame_bytes;
+    m_free_send_frames.splice(m_free_send_frames.end(), m_send_frames, iter);
+}
+
+void PacketXorDividerImpl::drop_stale_frames(uint64_t current_time)
+{
+    std::list<send_frame_t>::iterator iter = m_send_frames.begin();
+    while (m_send_frames.end() != iter)
+    {
+        std::list<send_frame_t>::iterator stale_iter = iter++;
+        if (0 != stale_iter->deadline && stale_iter->deadline < current_time)
+        {
+            drop_send_frame(stale_iter);
+        }
+    }
+}
+
+bool PacketXorDividerImpl::enqueue(const uint8_t * src_data, uint32_t src_size, int32_t frame_class)
+{
+    if (!m_send_queue_enabled || nullptr == src_data || 0 == src_size || frame_class >= static_cast<int32_t>(s_max_frame_class))
+    {
+        return false;
+    }
+
+    if (m_free_send_frames.empty())
+    {
+        m_free_send_frames.emplace_back();
+    }
+    m_send_frames.splice(m_send_frames.end(), m_free_send_frames, m_free_send_frames.begin());
+
+    send_frame_t & send_frame = m_send_frames.back();
+    send_frame.frame_class = frame_class;
+    send_frame.frame_data.assign(src_data, src_data + src_size);
+
+    const uint64_t current_time = get_steady_microseconds();
+    const uint32_t deadline_microseconds = ((frame_class >= 0 && 0 != m_frame_classes[frame_class].deadline_millisecond) ? static_cast<uint32_t>(m_frame_classes[frame_class].deadline_millisecond) * 1000 : m_frame_deadline_microseconds);
+    send_frame.enqueue_time = current_time;
+    send_frame.deadline = 0;
+    if (0 != deadline_microseconds)
+    {
+        send_frame.deadline = current_time + deadline_microseconds;
+    }
+    if (0 != m_max_queue_microseconds && (0 == send_frame.deadline || current_time + m_max_queue_microseconds < send_frame.deadline))
+    {
+        send_frame.deadline = current_time + m_max_queue_microseconds;
+    }
+
+    m_send_stats.queued_frames += 1;
+    m_send_stats.queued_bytes += src_size;
+
+    if (0 != m_max_queue_bytes && m_send_stats.queued_bytes > m_max_queue_bytes)
+    {
+        drop_stale_frames(current_time);
+        if (m_send_stats.queued_bytes > m_max_queue_bytes)
+        {
+            drop_send_frame(std::prev(m_send_frames.end()));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PacketXorDividerImpl::send(send_callback_t send_callback, void * user_data)
+{
+    const uint64_t current_time = get_steady_microseconds();
+    drop_stale_frames(current_time);
+
+    while (true)
+    {
+        for (; m_send_index < m_send_batch.size(); ++m_send_index)
+        {
+            if (!send_callback(user_data, m_send_batch.data(m_send_index), m_send_batch.length(m_send_index)))
+            {
+                return false;
+            }
+        }
+
+        m_send_batch.clear();
+        m_send_index = 0;
+
+        if (m_send_frames.empty())
+        {
+            if (m_aggregate_data.empty())
+            {
+                break;
+            }
+
+            flush_aggregate(m_send_batch);
+            continue;
+        }
+
+        send_frame_t & send_frame = m_send_frames.front();
+        const uint8_t * frame_data = &send_frame.frame_data[0];
+        const uint32_t frame_size = static_cast<uint32_t>(send_frame.frame_data.size());
+        m_send_stats.queued_frames -= 1;
+        m_send_stats.queued_bytes -= frame_size;
+
+        const bool encoded = (send_frame.frame_class < 0 ? encode_frame(frame_data, frame_size, m_send_batch) : encode(frame_data, frame_size, static_cast<uint8_t>(send_frame.frame_class), m_send_batch));
+        if (encoded)
+        {
+            const uint64_t queue_delay = current_time - std::min<uint64_t>(current_time, send_frame.enqueue_time);
+            const uint64_t sampled_frames = m_send_stats.sent_frames + 1;
+            m_send_stats.queue_delay_average_microseconds += (static_cast<double>(queue_delay) - m_send_stats.queue_delay_average_microseconds) / static_cast<double>(sampled_frames);
+            m_send_stats.queue_delay_max_microseconds = std::max<uint64_t>(m_send_stats.queue_delay_max_microseconds, queue_delay);
+            m_send_stats.sent_frames += 1;
+            m_send_stats.sent_bytes += frame_size;
+        }
+        else
+        {
+            m_send_stats.failed_frames += 1;
+            m_send_stats.failed_bytes += frame_size;
+        }
+
+        m_free_send_frames.splice(m_free_send_frames.end(), m_send_frames, m_send_frames.begin());
+    }
+
+    return true;
+}
+
+void PacketXorDividerImpl::get_send_stats(sender_stats_t & stats) const
+{
+    stats = m_send_stats;
+}
+
+bool PacketXorDividerImpl::set_frame_class(uint8_t frame_class, uint32_t xor_stride, uint32_t deadline_millisecond)
+{
+    if (frame_class >= s_max_frame_class || deadline_millisecond > 0xFFFF)
+    {
+        return false;
+    }
+
+    m_frame_classes[frame_class].xor_stride = xor_stride;
+    m_frame_classes[frame_class].deadline_millisecond = static_cast<uint16_t>(deadline_millisecond);
+
+    return true;
+}
+
+bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+{
+    return emit_batch(encode(src_data, src_size, frame_class, m_block_batch), dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, PacketBatch & dst_batch)
+{
+    if (nullptr == src_data || 0 == src_size || frame_class >= s_max_frame_class)
+    {
+        return false;
+    }
+
+    flush_aggregate(dst_batch);
+
+    block_ext_t block_ext = make_block_ext(s_ext_flag_frame_class);
+    block_ext.frame_class = frame_class;
+    block_ext.deadline_millisecond = m_frame_classes[frame_class].deadline_millisecond;
+
+    return divide_frame(src_data, src_size, m_frame_classes[frame_class].xor_stride, block_ext, dst_batch);
+}
+
+bool PacketXorDividerImpl::encode_object(const uint8_t * object_data, int file_descriptor, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data)
+{
+    if ((nullptr == object_data && file_descriptor < 0) || 0 == object_size || 0 == window_size || window_size > s_max_object_window_bytes || nullptr == encode_callback)
+    {
+        return false;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    emit_batch(flush_aggregate(m_block_batch), dst_list, encode_callback, user_data);
+
+    object_head_t object_head = { 0x0 };
+    object_head.object_id = ++m_object_id;
+    object_head.object_bytes = object_size;
+
+    for (uint64_t object_offset = 0; object_offset < object_size; object_offset += window_size)
+    {
+        const uint32_t window_bytes = static_cast<uint32_t>(std::min<uint64_t>(window_size, object_size - object_offset));
+        m_object_buffer.resize(sizeof(object_head) + window_bytes);
+
+        object_head_t window_head = object_head;
+        window_head.object_offset = object_offset;
+        window_head.encode();
+        memcpy(&m_object_buffer[0], &window_head, sizeof(window_head));
+
+        if (nullptr != object_data)
+        {
+            memcpy(&m_object_buffer[sizeof(window_head)], object_data + object_offset, window_bytes);
+        }
+        else if (!read_object_data(file_descriptor, object_offset, &m_object_buffer[sizeof(window_head)], window_bytes))
+        {
+            return false;
+        }
+
+        const bool ret = divide_frame(&m_object_buffer[0], static_cast<uint32_t>(m_object_buffer.size()), (m_use_xor ? 1 : 0), make_block_ext(s_ext_flag_object), m_block_batch);
+        if (!emit_batch(ret, dst_list, encode_callback, user_data))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PacketXorDividerImpl::emit_batch(bool ret, std::list<std::vector<uint8_t>> & dst_list, encode_callback_t encode_callback, void * user_data)
+{
+    PacketBatch dst_batch;
+    dst_batch.swap(m_block_batch);
+    for (std::size_t packet_index = 0; packet_index < dst_batch.size(); ++packet_index)
+    {
+        const uint8_t * packet_data = dst_batch.data(packet_index);
+        const uint32_t packet_length = dst_batch.length(packet_index);
+        if (nullptr != encode_callback)
+        {
+            (*encode_callback)(user_data, packet_data, packet_length);
+        }
+        else
+        {
+            dst_list.emplace_back(packet_data, packet_data + packet_length);
+        }
+    }
+    dst_batch.clear();
+    dst_batch.swap(m_block_batch);
+    return ret;
+}
+
+block_ext_t PacketXorDividerImpl::make_block_ext(uint8_t ext_flags) const
+{
+    block_ext_t block_ext = { 0x0 };
+    block_ext.ext_flags = static_cast<uint8_t>(ext_flags | (m_use_crc ? s_ext_flag_crc32c : 0x0));
+    return block_ext;
+}
+
+void PacketXorDividerImpl::reset()
+{
+    m_group_index = 0;
+    m_aggregate_data.clear();
+    m_retransmit_cache.reset();
+    m_parity_group_count = 0;
+    m_stream_sequence = 0;
+    m_stream_pending = 0;
+    m_stream_symbols.clear();
+    m_stream_batch.clear();
+    m_free_send_frames.splice(m_free_send_frames.end(), m_send_frames);
+    m_send_batch.clear();
+    m_send_index = 0;
+    memset(&m_send_stats, 0x0, sizeof(m_send_stats));
+    m_block_batch.clear();
+}
+
+class PacketXorUnifierImpl
+{
+public:
+    PacketXorUnifierImpl(uint32_t max_delay_microseconds = 1000 * 15, double fault_tolerance_rate = 0.0, uint64_t memory_budget_bytes = 0, uint32_t max_group_bytes = 0);
+    PacketXorUnifierImpl(const PacketXorUnifierImpl &) = delete;
+    PacketXorUnifierImpl(PacketXorUnifierImpl &&) = delete;
+    PacketXorUnifierImpl & operator = (const PacketXorUnifierImpl &) = delete;
+    PacketXorUnifierImpl & operator = (PacketXorUnifierImpl &&) = delete;
+    ~PacketXorUnifierImpl();
+
+public:
+    bool decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
+    bool decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data);
+    bool decode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch);
+    bool decode(const uint8_t * src_data, uint32_t src_size, reserve_callback_t reserve_callback, decode_callback_t commit_callback, void * user_data);
+    bool decode(const PacketBatch & src_batch, const std::vector<block_view_t> & block_views, PacketBatch & dst_batch);
+
+public:
+    uint64_t next_deadline() const;
+    bool poll(uint64_t now_microseconds, std::list<std::vector<uint8_t>> & dst_list);
+    bool poll(uint64_t now_microseconds, decode_callback_t decode_callback, void * user_data);
+    bool poll(uint64_t now_microseconds, PacketBatch & dst_batch);
+    static uint64_t current_microseconds();
+
+public:
+    static bool recognizable(const uint8_t * src_data, uint32_t src_size);
+    static std::size_t classify(const PacketBatch & src_batch, std::vector<uint64_t> & valid_mask, std::vector<block_view_t> & block_views);
+
+public:
+    bool set_nack(uint32_t nack_delay_microseconds, nack_callback_t nack_callback, void * user_data);
+    bool set_adaptive_expiry(uint32_t min_expire_microseconds, uint32_t max_expire_microseconds, double jitter_factor);
+    bool set_lazy_recovery(bool lazy_recovery, uint32_t margin_microseconds);
+
+public:
+    bool set_object_output(const char * file_path, object_callback_t object_callback, void * user_data);
+    bool set_progress(progress_callback_t progress_callback, complete_callback_t complete_callback, void * user_data);
+
+public:
+    bool set_trace(const char * trace_path, bool with_payload);
+    bool replay(const char * trace_path, decode_callback_t decode_callback, void * user_data, replay_stats_t & stats);
+
+public:
+    void get_stats(unifier_stats_t & stats) const;
+    bool get_path_stats(uint32_t path_index, path_stats_t & stats) const;
+
+public:
+    void recycle(std::vector<uint8_t> && frame);
+
+public:
+    void reset();
+
+private:
+    const uint32_t      m_max_delay_microseconds;
+    const double        m_fault_tolerance_rate;
+
+private:
+    groups_t            m_groups;
+};
+
+PacketXorUnifierImpl::PacketXorUnifierImpl(uint32_t max_delay_microseconds, double fault_tolerance_rate, uint64_t memory_budget_bytes, uint32_t max_group_bytes)
+    : m_max_delay_microseconds(std::max<uint32_t>(max_delay_microseconds, 500))
+    , m_fault_tolerance_rate(std::max<double>(std::min<double>(fault_tolerance_rate, 1.0), 0.0))
+    , m_groups(memory_budget_bytes, max_group_bytes)
+{
+
+}
+
+PacketXorUnifierImpl::~PacketXorUnifierImpl()
+{
+    close_object_output(m_groups.object_output, true);
+    close_trace_output(m_groups.trace_output);
+}
+
+bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return packet_unify(src_data, src_size, m_groups, get_steady_microseconds(), dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr, nullptr);
+}
+
+bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return packet_unify(src_data, src_size, m_groups, get_steady_microseconds(), dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, decode_callback, user_data);
+}
+
+bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return packet_unify(src_data, src_size, m_groups, get_steady_microseconds(), dst_list, &dst_batch, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr, nullptr);
+}
+
+bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, reserve_callback_t reserve_callback, decode_callback_t commit_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return packet_unify(src_data, src_size, m_groups, get_steady_microseconds(), dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, reserve_callback, commit_callback, user_data);
+}
+
+bool PacketXorUnifierImpl::decode(const PacketBatch & src_batch, const std::vector<block_view_t> & block_views, PacketBatch & dst_batch)
+{
+    if (block_views.size() != src_batch.size())
+    {
+        return false;
+    }
+
+    bool decoded = false;
+    std::list<std::vector<uint8_t>> dst_list;
+    for (std::size_t packet_index = 0; packet_index < src_batch.size(); ++packet_index)
+    {
+        const block_view_t & block_view = block_views[packet_index];
+        if (0 == block_view.protocol_id)
+        {
+            continue;
+        }
+
+        const uint8_t * src_data = src_batch.data(packet_index);
+        const uint32_t src_size = src_batch.length(packet_index);
+        if (block_view.head_offset < src_size && (s_protocol_seq == block_view.protocol_id || s_protocol_xor == block_view.protocol_id))
+        {
+            m_groups.hint_data = src_data + block_view.head_offset;
+            m_groups.hint_view = &block_view;
+        }
+
+        decoded = packet_unify(src_data, src_size, m_groups, get_steady_microseconds(), dst_list, &dst_batch, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr, nullptr) || decoded;
+
+        m_groups.hint_data = nullptr;
+        m_groups.hint_view = nullptr;
+    }
+
+    return decoded;
+}
+
+uint64_t PacketXorUnifierImpl::next_deadline() const
+{
+    return next_unify_deadline(m_groups);
+}
+
+bool PacketXorUnifierImpl::poll(uint64_t now_microseconds, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return packet_unify(nullptr, 0, m_groups, (0 != now_microseconds ? now_microseconds : get_steady_microseconds()), dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr, nullptr);
+}
+
+bool PacketXorUnifierImpl::poll(uint64_t now_microseconds, decode_callback_t decode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return packet_unify(nullptr, 0, m_groups, (0 != now_microseconds ? now_microseconds : get_steady_microseconds()), dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, decode_callback, user_data);
+}
+
+bool PacketXorUnifierImpl::poll(uint64_t now_microseconds, PacketBatch & dst_batch)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return packet_unify(nullptr, 0, m_groups, (0 != now_microseconds ? now_microseconds : get_steady_microseconds()), dst_list, &dst_batch, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr, nullptr);
+}
+
+uint64_t PacketXorUnifierImpl::current_microseconds()
+{
+    return get_steady_microseconds();
+}
+
+bool PacketXorUnifierImpl::recognizable(const uint8_t * src_data, uint32_t src_size)
+{
+    return check_package(src_data, src_size);
+}
+
+std::size_t PacketXorUnifierImpl::classify(const PacketBatch & src_batch, std::vector<uint64_t> & valid_mask, std::vector<block_view_t> & block_views)
+{
+    return classify_batch(src_batch, valid_mask, block_views);
+}
+
+bool PacketXorUnifierImpl::set_nack(uint32_t nack_delay_microseconds, nack_callback_t nack_callback, void * user_data)
+{
+    if (0 != nack_delay_microseconds && nullptr == nack_callback)
+    {
+        return false;
+    }
+
+    m_groups.nack_delay_microseconds = nack_delay_microseconds;
+    m_groups.nack_callback = nack_callback;
+    m_groups.nack_user_data = user_data;
+
+    return true;
+}
+
+bool PacketXorUnifierImpl::set_adaptive_expiry(uint32_t min_expire_microseconds, uint32_t max_expire_microseconds, double jitter_factor)
+{
+    expire_estimator_t & estimator = m_groups.expire_estimator;
+    if (0 == max_expire_microseconds)
+    {
+        estimator.enabled = false;
+        return true;
+    }
+
+    if (min_expire_microseconds > max_expire_microseconds || jitter_factor < 0.0)
+    {
+        return false;
+    }
+
+    estimator.enabled = true;
+    estimator.min_expire_microseconds = min_expire_microseconds;
+    estimator.max_expire_microseconds = max_expire_microseconds;
+    estimator.jitter_factor = jitter_factor;
+    estimator.reset();
+
+    return true;
+}
+
+bool PacketXorUnifierImpl::set_lazy_recovery(bool lazy_recovery, uint32_t margin_microseconds)
+{
+    if (lazy_recovery != m_groups.lazy_recovery && !m_groups.group_items.empty())
+    {
+        return false;
+    }
+
+    m_groups.lazy_recovery = lazy_recovery;
+    m_groups.lazy_margin_microseconds = margin_microseconds;
+
+    return true;
+}
+
+bool PacketXorUnifierImpl::set_trace(const char * trace_path, bool with_payload)
+{
+    trace_output_t & output = m_groups.trace_output;
+    close_trace_output(output);
+    output.with_payload = with_payload;
+
+    if (nullptr == trace_path)
+    {
+        return true;
+    }
+
+    output.file = fopen(trace_path, "wb");
+    if (nullptr == output.file)
+    {
+        return false;
+    }
+
+    trace_head_t trace_head = { 0x0 };
+    trace_head.magic = s_trace_magic;
+    trace_head.version = s_trace_version;
+    trace_head.flags = (with_payload ? s_trace_flag_payload : 0x0);
+    trace_head.encode();
+
+    const uint8_t * head_data = reinterpret_cast<const uint8_t *>(&trace_head);
+    output.buffer.reserve(s_trace_buffer_bytes);
+    output.buffer.assign(head_data, head_data + sizeof(trace_head));
+
+    return true;
+}
+
+struct replay_sink_t
+{
+    decode_callback_t                   decode_callback;
+    void                              * user_data;
+    replay_stats_t                    * stats;
+};
+
+static void replay_frame(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    replay_sink_t * sink = reinterpret_cast<replay_sink_t *>(user_data);
+    sink->stats->delivered_frames += 1;
+    sink->stats->delivered_bytes += dst_size;
+    if (nullptr != sink->decode_callback)
+    {
+        (*sink->decode_callback)(sink->user_data, dst_data, dst_size);
+    }
+}
+
+bool PacketXorUnifierImpl::replay(const char * trace_path, decode_callback_t decode_callback, void * user_data, replay_stats_t & stats)
+{
+    memset(&stats, 0x0, sizeof(stats));
+
+    std::FILE * file = (nullptr != trace_path ? fopen(trace_path, "rb") : nullptr);
+    if (nullptr == file)
+    {
+        return false;
+    }
+
+    trace_head_t trace_head = { 0x0 };
+    bool ret = (1 == fread(&trace_head, sizeof(trace_head), 1, file));
+    trace_head.decode();
+    ret = ret && s_trace_magic == trace_head.magic && s_trace_version == trace_head.version;
+
+    m_groups.reset();
+    m_groups.replaying = true;
+    m_groups.replay_stats = &stats;
+
+    replay_sink_t sink = { decode_callback, user_data, &stats };
+    std::list<std::vector<uint8_t>> dst_list;
+    std::vector<uint8_t> datagram;
+    uint64_t first_timestamp = 0;
+    trace_record_t trace_record = { 0x0 };
+    while (ret && 1 == fread(&trace_record, sizeof(trace_record), 1, file))
+    {
+        trace_record.decode();
+        if (trace_record.captured_bytes > trace_record.datagram_bytes || trace_record.datagram_bytes > s_max_trace_datagram_bytes)
+        {
+            ret = false;
+            break;
+        }
+
+        datagram.assign(trace_record.datagram_bytes, 0x0);
+        if (0 != trace_record.captured_bytes && 1 != fread(&datagram[0], trace_record.captured_bytes, 1, file))
+        {
+            ret = false;
+            break;
+        }
+
+        if (0 == stats.trace_records)
+        {
+            first_timestamp = trace_record.timestamp;
+        }
+        stats.trace_records += 1;
+        stats.trace_datagrams += (0 != trace_record.datagram_bytes ? 1 : 0);
+        stats.trace_microseconds = trace_record.timestamp - first_timestamp;
+
+        m_groups.skip_checksum = (trace_record.captured_bytes < trace_record.datagram_bytes);
+        packet_unify((datagram.empty() ? nullptr : datagram.data()), trace_record.datagram_bytes, m_groups, trace_record.timestamp, dst_list, nullptr, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, &replay_frame, &sink);
+    }
+
+    m_groups.replaying = false;
+    m_groups.skip_checksum = false;
+    m_groups.replay_stats = nullptr;
+
+    fclose(file);
+
+    return ret;
+}
+
+bool PacketXorUnifierImpl::set_object_output(const char * file_path, object_callback_t object_callback, void * user_data)
+{
+    object_output_t & output = m_groups.object_output;
+    close_object_output(output, true);
+    output.object_callback = object_callback;
+    output.user_data = user_data;
+
+    if (nullptr == file_path)
+    {
+        return true;
+    }
+
+#ifndef _MSC_VER
+    output.file_descriptor = open(file_path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    return -1 != output.file_descriptor;
+#else
+    return false;
+#endif // _MSC_VER
+}
+
+bool PacketXorUnifierImpl::set_progress(progress_callback_t progress_callback, complete_callback_t complete_callback, void * user_data)
+{
+    if (nullptr == progress_callback && nullptr != complete_callback)
+    {
+        return false;
+    }
+
+    m_groups.progress_callback = progress_callback;
+    m_groups.complete_callback = complete_callback;
+    m_groups.progress_user_data = user_data;
+
+    return true;
+}
+
+void PacketXorUnifierImpl::get_stats(unifier_stats_t & stats) const
+{
+    stats.checksum_error_blocks = m_groups.checksum_error_blocks;
+    stats.memory_budget_bytes = m_groups.memory_budget_bytes;
+    stats.memory_used_bytes = m_groups.memory_used_bytes;
+    stats.memory_peak_bytes = m_groups.memory_peak_bytes;
+    stats.rejected_groups = m_groups.rejected_groups;
+    stats.evicted_groups = m_groups.evicted_groups;
+    stats.nack_messages = m_groups.nack_messages;
+    stats.nack_blocks = m_groups.nack_blocks;
+    stats.gap_average_microseconds = m_groups.expire_estimator.gap_average;
+    stats.gap_deviation_microseconds = m_groups.expire_estimator.gap_deviation;
+    stats.spread_average_microseconds = m_groups.expire_estimator.spread_average;
+    stats.spread_deviation_microseconds = m_groups.expire_estimator.spread_deviation;
+    stats.object_windows = m_groups.object_windows;
+    stats.object_dropped_windows = m_groups.object_dropped_windows;
+    stats.parity_recovered_groups = m_groups.cross_parity.recovered_groups;
+    stats.xor_processed_bytes = m_groups.xor_processed_bytes;
+    stats.stream_recovered_blocks = m_groups.stream_decoder.recovered_blocks;
+}
+
+void PacketXorUnifierImpl::recycle(std::vector<uint8_t> && frame)
+{
+    recycle_frame(m_groups, std::move(frame));
+}
+
+bool PacketXorUnifierImpl::get_path_stats(uint32_t path_index, path_stats_t & stats) const
+{
+    memset(&stats, 0x0, sizeof(stats));
+    if (path_index >= s_max_path_count)
+    {
+        return false;
+    }
+
+    const path_state_t & path_state = m_groups.path_states[path_index];
+    if (!path_state.active)
+    {
+        return true;
+    }
+
+    double min_delay = path_state.delay_average;
+    for (std::vector<path_state_t>::const_iterator iter = m_groups.path_states.begin(); m_groups.path_states.end() != iter; ++iter)
+    {
+        if (iter->delay_valid)
+        {
+            min_delay = std::min<double>(min_delay, iter->delay_average);
+        }
+    }
+
+    const uint64_t expect_blocks = path_state.max_sequence - path_state.first_sequence + 1;
+    stats.received_blocks = path_state.received_blocks;
+    stats.received_bytes = path_state.received_bytes;
+    stats.lost_blocks = (expect_blocks > path_state.received_blocks ? expect_blocks - path_state.received_blocks : 0);
+    stats.relative_delay_microseconds = path_state.delay_average - min_delay;
+    stats.jitter_microseconds = path_state.delay_deviation;
+
+    return true;
+}
+
+void PacketXorUnifierImpl::reset()
+{
+    m_groups.reset();
+}
+
+class PacketXorStriperImpl
+{
+public:
+    PacketXorStriperImpl(uint32_t path_count, const uint32_t * path_weights, stripe_callback_t stripe_callback, void * user_data);
+    PacketXorStriperImpl(const PacketXorStriperImpl &) = delete;
+    PacketXorStriperImpl(PacketXorStriperImpl &&) = delete;
+    PacketXorStriperImpl & operator = (const PacketXorStriperImpl &) = delete;
+    PacketXorStriperImpl & operator = (PacketXorStriperImpl &&) = delete;
+    ~PacketXorStriperImpl();
+
+public:
+    bool set_path_weight(uint32_t path_index, uint32_t path_weight);
+    bool set_path_capacity(uint32_t path_index, double path_capacity);
+
+public:
+    bool send(const uint8_t * src_data, uint32_t src_size);
+
+public:
+    void reset();
+
+private:
+    uint32_t pick_path(uint32_t exclude_mask, uint32_t relax_mask);
+
+private:
+    const uint32_t          m_path_count;
+    stripe_callback_t       m_stripe_callback;
+    void                  * m_user_data;
+
+private:
+    std::vector<uint32_t>   m_path_weights;
+    std::vector<double>     m_path_capacities;
+    std::vector<double>     m_current_weights;
+    std::vector<uint64_t>   m_path_sequences;
+
+private:
+    bool                    m_seq_valid;
+    uint64_t                m_seq_group_index;
+    uint32_t                m_seq_block_index;
+    uint32_t                m_cur_seq_path;
+    uint32_t                m_pre_seq_path;
+
+private:
+    std::vector<uint8_t>    m_packet_buffer;
+};
+
+PacketXorStriperImpl::PacketXorStriperImpl(uint32_t path_count, const uint32_t * path_weights, stripe_callback_t stripe_callback, void * user_data)
+    : m_path_count(path_count)
+    , m_stripe_callback(stripe_callback)
+    , m_user_data(user_data)
+    , m_path_weights(path_count, 1)
+    , m_path_capacities(path_count, 1.0)
+    , m_current_weights(path_count, 0.0)
+    , m_path_sequences(path_count, 0)
+    , m_seq_valid(false)
+    , m_seq_group_index(0)
+    , m_seq_block_index(0)
+    , m_cur_seq_path(0)
+    , m_pre_seq_path(0)
+    , m_packet_buffer()
+{
+    if (nullptr != path_weights)
+    {
+        m_path_weights.assign(path_weights, path_weights + path_count);
+    }
+}
+
+PacketXorStriperImpl::~PacketXorStriperImpl()
+{
+
+}
+
+bool PacketXorStriperImpl::set_path_weight(uint32_t path_index, uint32_t path_weight)
+{
+    if (path_index >= m_path_count)
+    {
+        return false;
+    }
+    m_path_weights[path_index] = path_weight;
+    return true;
+}
+
+bool PacketXorStriperImpl::set_path_capacity(uint32_t path_index, double path_capacity)
+{
+    if (path_index >= m_path_count || path_capacity < 0.0)
+    {
+        return false;
+    }
+    m_path_capacities[path_index] = path_capacity;
+    return true;
+}
+
+uint32_t PacketXorStriperImpl::pick_path(uint32_t exclude_mask, uint32_t relax_mask)
+{
+    uint32_t active_mask = 0;
+    for (uint32_t path_index = 0; path_index < m_path_count; ++path_index)
+    {
+        if (m_path_weights[path_index] * m_path_capacities[path_index] > 0.0)
+        {
+            active_mask |= (1u << path_index);
+        }
+    }
+
+    if (0 == (active_mask & ~exclude_mask))
+    {
+        exclude_mask = relax_mask;
+    }
+    if (0 == (active_mask & ~exclude_mask))
+    {
+        exclude_mask = 0;
+    }
+
+    double total_weight = 0.0;
+    uint32_t best_path = m_path_count;
+    for (uint32_t path_index = 0; path_index < m_path_count; ++path_index)
+    {
+        if (0 == (active_mask & (1u << path_index)))
+        {
+            continue;
+        }
+        const double path_weight = m_path_weights[path_index] * m_path_capacities[path_index];
+        m_current_weights[path_index] += path_weight;
+        total_weight += path_weight;
+        if (0 == (exclude_mask & (1u << path_index)) && (m_path_count == best_path || m_current_weights[path_index] > m_current_weights[best_path]))
+        {
+            best_path = path_index;
+        }
+    }
+
+    if (best_path < m_path_count)
+    {
+        m_current_weights[best_path] -= total_weight;
+    }
+
+    return best_path;
+}
+
+bool PacketXorStriperImpl::send(const uint8_t * src_data, uint32_t src_size)
+{
+    if (nullptr == src_data || 0 == src_size)
+    {
+        return false;
+    }
+
+    uint8_t protocol_id = 0x0;
+    uint64_t group_index = 0;
+    uint32_t block_index = 0;
+    uint32_t exclude_mask = 0;
+    uint32_t relax_mask = 0;
+    if (src_size >= sizeof(block_t))
+    {
+        block_t block = *reinterpret_cast<const block_t *>(src_data);
+        block.decode();
+        protocol_id = static_cast<uint8_t>(block.protocol_id & ~s_protocol_ext);
+        group_index = block.group_index;
+        block_index = static_cast<uint32_t>(static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
+    }
+
+    const bool same_group = (m_seq_valid && group_index == m_seq_group_index);
+    if (s_protocol_seq == protocol_id && same_group && block_index == m_seq_block_index)
+    {
+        exclude_mask = relax_mask = (1u << m_cur_seq_path);
+    }
+    else if (s_protocol_seq == protocol_id && same_group && 1 == block_index && 0 == m_seq_block_index)
+    {
+        exclude_mask = (1u << m_cur_seq_path);
+    }
+    else if (s_protocol_xor == protocol_id && same_group && block_index == m_seq_block_index)
+    {
+        relax_mask = (1u << m_cur_seq_path);
+        exclude_mask = relax_mask | (block_index > 0 ? (1u << m_pre_seq_path) : 0);
+    }
+    else if (s_protocol_parity == protocol_id && m_seq_valid)
+    {
+        exclude_mask = relax_mask = (1u << m_cur_seq_path);
+    }
+
+    const uint32_t path_index = pick_path(exclude_mask, relax_mask);
+    if (path_index >= m_path_count)
+    {
+        return false;
+    }
+
+    if (s_protocol_seq == protocol_id && !(same_group && block_index == m_seq_block_index))
+    {
+        m_pre_seq_path = (same_group && block_index == m_seq_block_index + 1 ? m_cur_seq_path : path_index);
+        m_cur_seq_path = path_index;
+        m_seq_group_index = group_index;
+        m_seq_block_index = block_index;
+        m_seq_valid = true;
+    }
+
+    path_head_t path_head = { 0x0 };
+    path_head.path_sequence = m_path_sequences[path_index]++;
+    path_head.protocol_id = s_protocol_path;
+    path_head.path_index = static_cast<uint8_t>(path_index);
+    path_head.send_time = static_cast<uint32_t>(get_steady_microseconds());
+    path_head.encode();
+
+    m_packet_buffer.resize(sizeof(path_head) + src_size);
+    memcpy(&m_packet_buffer[0], &path_head, sizeof(path_head));
+    memcpy(&m_packet_buffer[sizeof(path_head)], src_data, src_size);
+
+    (*m_stripe_callback)(m_user_data, path_index, m_packet_buffer.data(), static_cast<uint32_t>(m_packet_buffer.size()));
+
+    return true;
+}
+
+void PacketXorStriperImpl::reset()
+{
+    m_current_weights.assign(m_path_count, 0.0);
+    m_path_sequences.assign(m_path_count, 0);
+    m_seq_valid = false;
+}
+
+PacketBatch::PacketBatch()
+    : m_arena()
+    , m_arena_size(0)
+    , m_offsets()
+    , m_lengths()
+{
+
+}
+
+void PacketBatch::clear()
+{
+    m_arena_size = 0;
+    m_offsets.clear();
+    m_lengths.clear();
+}
+
+void PacketBatch::reserve(std::size_t packet_count, std::size_t arena_bytes)
+{
+    m_offsets.reserve(m_offsets.size() + packet_count);
+    m_lengths.reserve(m_lengths.size() + packet_count);
+    if (m_arena.size() < m_arena_size + arena_bytes)
+    {
+        m_arena.resize(m_arena_size + arena_bytes);
+    }
+}
+
+void PacketBatch::swap(PacketBatch & other)
+{
+    m_arena.swap(other.m_arena);
+    std::swap(m_arena_size, other.m_arena_size);
+    m_offsets.swap(other.m_offsets);
+    m_lengths.swap(other.m_lengths);
+}
+
+std::size_t PacketBatch::size() const
+{
+    return m_offsets.size();
+}
+
+bool PacketBatch::empty() const
+{
+    return m_offsets.empty();
+}
+
+const uint8_t * PacketBatch::data(std::size_t packet_index) const
+{
+    return m_arena.data() + m_offsets[packet_index];
+}
+
+uint32_t PacketBatch::length(std::size_t packet_index) const
+{
+    return m_lengths[packet_index];
+}
+
+std::size_t PacketBatch::offset(std::size_t packet_index) const
+{
+    return m_offsets[packet_index];
+}
+
+const uint8_t * PacketBatch::arena() const
+{
+    return m_arena.data();
+}
+
+std::size_t PacketBatch::arena_size() const
+{
+    return m_arena_size;
+}
+
+uint8_t * PacketBatch::append(uint32_t packet_length)
+{
+    if (m_arena.size() < m_arena_size + packet_length)
+    {
+        m_arena.resize(std::max<std::size_t>(m_arena_size + packet_length, m_arena.size() * 2));
+    }
+    m_offsets.push_back(m_arena_size);
+    m_lengths.push_back(packet_length);
+    m_arena_size += packet_length;
+    return m_arena.data() + m_offsets.back();
+}
+
+void PacketBatch::append(const uint8_t * packet_data, uint32_t packet_length)
+{
+    const bool inside_arena = !m_arena.empty() && packet_data >= m_arena.data() && packet_data < m_arena.data() + m_arena.size();
+    const std::size_t packet_offset = (inside_arena ? static_cast<std::size_t>(packet_data - m_arena.data()) : 0);
+    uint8_t * dst_data = append(packet_length);
+    memcpy(dst_data, (inside_arena ? m_arena.data() + packet_offset : packet_data), packet_length);
+}
+
+struct fanout_frame_t
+{
+    PacketBatch                         packet_batch;
+    std::vector<uint32_t>               body_crcs;
+    std::vector<uint32_t>               body_shifts;
+};
+
+struct fanout_session_t
+{
+    uint64_t                            group_index;
+    std::shared_ptr<fanout_frame_t>     frame;
+    std::vector<uint8_t>                head_data;
+    std::vector<fanout_packet_t>        packets;
+
+    fanout_session_t()
+        : group_index(0)
+        , frame()
+        , head_data()
+        , packets()
+    {
+
+    }
+};
+
+class PacketXorFanoutImpl
+{
+public:
+    PacketXorFanoutImpl(uint32_t max_block_size, bool use_xor, bool use_crc);
+    PacketXorFanoutImpl(const PacketXorFanoutImpl &) = delete;
+    PacketXorFanoutImpl(PacketXorFanoutImpl &&) = delete;
+    PacketXorFanoutImpl & operator = (const PacketXorFanoutImpl &) = delete;
+    PacketXorFanoutImpl & operator = (PacketXorFanoutImpl &&) = delete;
+    ~PacketXorFanoutImpl();
+
+public:
+    bool add_session(uint32_t session_id);
+    bool remove_session(uint32_t session_id);
+
+public:
+    bool encode(const uint8_t * src_data, uint32_t src_size);
+    bool emit(uint32_t session_id, std::vector<fanout_packet_t> & dst_packets);
+    bool emit(fanout_callback_t fanout_callback, void * user_data);
+
+public:
+    void reset();
+
+private:
+    bool emit_session(fanout_session_t & session);
+
+private:
+    const uint32_t      m_max_block_size;
+    const bool          m_use_xor;
+    const bool          m_use_crc;
+
+private:
+    std::shared_ptr<fanout_frame_t>                 m_frame;
+    std::vector<std::shared_ptr<fanout_frame_t>>    m_free_frames;
+    std::map<uint32_t, fanout_session_t>            m_sessions;
+};
+
+PacketXorFanoutImpl::PacketXorFanoutImpl(uint32_t max_block_size, bool use_xor, bool use_crc)
+    : m_max_block_size(std::max<uint32_t>(max_block_size, block_head_size(use_crc) + 1))
+    , m_use_xor(use_xor)
+    , m_use_crc(use_crc)
+    , m_frame()
+    , m_free_frames()
+    , m_sessions()
+{
+
+}
+
+PacketXorFanoutImpl::~PacketXorFanoutImpl()
+{
+
+}
+
+bool PacketXorFanoutImpl::add_session(uint32_t session_id)
+{
+    return m_sessions.insert(std::make_pair(session_id, fanout_session_t())).second;
+}
+
+bool PacketXorFanoutImpl::remove_session(uint32_t session_id)
+{
+    return 0 != m_sessions.erase(session_id);
+}
+
+bool PacketXorFanoutImpl::encode(const uint8_t * src_data, uint32_t src_size)
+{
+    std::shared_ptr<fanout_frame_t> frame;
+    for (std::vector<std::shared_ptr<fanout_frame_t>>::iterator iter = m_free_frames.begin(); m_free_frames.end() != iter; ++iter)
+    {
+        if (1 == iter->use_count())
+        {
+            frame = *iter;
+            break;
+        }
+    }
+    if (!frame)
+    {
+        frame = std::make_shared<fanout_frame_t>();
+        if (m_free_frames.size() < s_max_free_frames)
+        {
+            m_free_frames.push_back(frame);
+        }
+    }
+
+    block_ext_t block_ext = { 0x0 };
+    block_ext.ext_flags = (m_use_crc ? s_ext_flag_crc32c : 0x0);
+    const uint32_t head_size = block_head_size(0 != block_ext.ext_flags);
+
+    uint64_t group_index = 0;
+    frame->packet_batch.clear();
+    if (!packet_divide(src_data, src_size, m_max_block_size, (m_use_xor ? 1 : 0), block_ext, group_index, nullptr, frame->packet_batch))
+    {
+        return false;
+    }
+
+    frame->body_crcs.clear();
+    frame->body_shifts.clear();
+    if (m_use_crc)
+    {
+        for (std::size_t packet_index = 0; packet_index < frame->packet_batch.size(); ++packet_index)
+        {
+            const uint32_t body_size = frame->packet_batch.length(packet_index) - head_size;
+            frame->body_crcs.push_back(crc32c_update(0, frame->packet_batch.data(packet_index) + head_size, body_size));
+            frame->body_shifts.push_back(crc32c_shift(body_size));
+        }
+    }
+
+    m_frame = frame;
+
+    return true;
+}
+
+bool PacketXorFanoutImpl::emit_session(fanout_session_t & session)
+{
+    if (!m_frame)
+    {
+        return false;
+    }
+
+    const PacketBatch & packet_batch = m_frame->packet_batch;
+    const uint32_t head_size = block_head_size(m_use_crc);
+    const std::size_t packet_count = packet_batch.size();
+
+    session.frame = m_frame;
+    session.head_data.resize(packet_count * head_size);
+    session.packets.resize(packet_count);
+
+    uint64_t group_index = session.group_index++;
+    host_to_net(&group_index, sizeof(group_index));
+
+    for (std::size_t packet_index = 0; packet_index < packet_count; ++packet_index)
+    {
+        const uint8_t * packet_data = packet_batch.data(packet_index);
+        uint8_t * head_data = &session.head_data[packet_index * head_size];
+        memcpy(head_data, packet_data, head_size);
+        memcpy(head_data + offsetof(block_t, group_index), &group_index, sizeof(group_index));
+        if (m_use_crc)
+        {
+            memset(head_data + sizeof(block_t) + offsetof(block_ext_t, checksum), 0x0, sizeof(uint32_t));
+            seal_block_checksum(head_data, crc32c_combine(crc32c_update(0, head_data, head_size), m_frame->body_crcs[packet_index], m_frame->body_shifts[packet_index]));
+        }
+
+        fanout_packet_t & packet = session.packets[packet_index];
+        packet.head_data = head_data;
+        packet.head_size = head_size;
+        packet.body_data = packet_data + head_size;
+        packet.body_size = packet_batch.length(packet_index) - head_size;
+    }
+
+    return true;
+}
+
+bool PacketXorFanoutImpl::emit(uint32_t session_id, std::vector<fanout_packet_t> & dst_packets)
+{
+    std::map<uint32_t, fanout_session_t>::iterator iter = m_sessions.find(session_id);
+    if (m_sessions.end() == iter || !emit_session(iter->second))
+    {
+        return false;
+    }
+
+    dst_packets = iter->second.packets;
+
+    return true;
+}
+
+bool PacketXorFanoutImpl::emit(fanout_callback_t fanout_callback, void * user_data)
+{
+    if (!m_frame)
+    {
+        return false;
+    }
+
+    for (std::map<uint32_t, fanout_session_t>::iterator iter = m_sessions.begin(); m_sessions.end() != iter; ++iter)
+    {
+        fanout_session_t & session = iter->second;
+        if (emit_session(session))
+        {
+            fanout_callback(user_data, iter->first, session.packets.data(), static_cast<uint32_t>(session.packets.size()));
+        }
+    }
+
+    return true;
+}
+
+void PacketXorFanoutImpl::reset()
+{
+    m_frame.reset();
+    for (std::map<uint32_t, fanout_session_t>::iterator iter = m_sessions.begin(); m_sessions.end() != iter; ++iter)
+    {
+        iter->second = fanout_session_t();
+    }
+}
+
+PacketXorDivider::PacketXorDivider()
+    : m_divider(nullptr)
+{
+
+}
+
+PacketXorDivider::~PacketXorDivider()
+{
+    exit();
+}
+
+bool PacketXorDivider::init(uint32_t max_block_size, bool use_xor, bool use_crc)
+{
+    exit();
+
+    return nullptr != (m_divider = new PacketXorDividerImpl(max_block_size, use_xor, use_crc));
+}
+
+void PacketXorDivider::exit()
+{
+    if (nullptr != m_divider)
+    {
+        delete m_divider;
+        m_divider = nullptr;
+    }
+}
+
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, dst_list);
+}
+
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data)
+{
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, encode_callback, user_data);
+}
+
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch)
+{
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, dst_batch);
+}
+
+bool PacketXorDivider::set_aggregation(uint32_t max_message_size, uint32_t max_delay_millisecond)
+{
+    return nullptr != m_divider && m_divider->set_aggregation(max_message_size, max_delay_millisecond * 1000);
+}
+
+bool PacketXorDivider::poll(std::list<std::vector<uint8_t>> & dst_list)
+{
+    return nullptr != m_divider && m_divider->poll(dst_list, nullptr, nullptr);
+}
+
+bool PacketXorDivider::poll(encode_callback_t encode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return nullptr != m_divider && m_divider->poll(dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDivider::poll(PacketBatch & dst_batch)
+{
+    return nullptr != m_divider && m_divider->poll(dst_batch);
+}
+
+bool PacketXorDivider::flush(std::list<std::vector<uint8_t>> & dst_list)
+{
+    return nullptr != m_divider && m_divider->flush(dst_list, nullptr, nullptr);
+}
+
+bool PacketXorDivider::flush(encode_callback_t encode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return nullptr != m_divider && m_divider->flush(dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDivider::flush(PacketBatch & dst_batch)
+{
+    return nullptr != m_divider && m_divider->flush(dst_batch);
+}
+
+bool PacketXorDivider::set_cross_parity(uint32_t window_groups, uint32_t max_delay_millisecond)
+{
+    return nullptr != m_divider && m_divider->set_cross_parity(window_groups, max_delay_millisecond * 1000);
+}
+
+bool PacketXorDivider::set_stream_fec(uint32_t window_blocks, uint32_t repair_interval)
+{
+    return nullptr != m_divider && m_divider->set_stream_fec(window_blocks, repair_interval);
+}
+
+bool PacketXorDivider::set_send_queue(uint64_t max_queue_bytes, uint32_t max_queue_millisecond, uint32_t frame_deadline_millisecond)
+{
+    return nullptr != m_divider && m_divider->set_send_queue(max_queue_bytes, max_queue_millisecond * 1000, frame_deadline_millisecond * 1000);
+}
+
+bool PacketXorDivider::enqueue(const uint8_t * src_data, uint32_t src_size)
+{
+    return nullptr != m_divider && m_divider->enqueue(src_data, src_size, -1);
+}
+
+bool PacketXorDivider::enqueue(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class)
+{
+    return nullptr != m_divider && m_divider->enqueue(src_data, src_size, frame_class);
+}
+
+bool PacketXorDivider::send(send_callback_t send_callback, void * user_data)
+{
+    return nullptr != m_divider && nullptr != send_callback && m_divider->send(send_callback, user_data);
+}
 
-    uint32_t block_index = static_cast<uint32_t>(static_cast<uint32_t>(block.block_idx_h) << 16) | static_cast<uint32_t>(block.block_idx_l);
-    if (block_index >= block.block_count)
-    {
-        return false;
-    }
-    else if (block_index + 1 == block.block_count)
+void PacketXorDivider::get_send_stats(sender_stats_t & stats) const
+{
+    if (nullptr != m_divider)
     {
-        if (sizeof(block) + block.block_bytes > size || block.block_pos + block.block_bytes < block.group_bytes)
-        {
-            return false;
-        }
+        m_divider->get_send_stats(stats);
     }
     else
     {
-        if (sizeof(block) + block.block_bytes != size || block.block_pos + block.block_bytes > block.group_bytes)
-        {
-            return false;
-        }
+        memset(&stats, 0x0, sizeof(stats));
     }
+}
 
-    return true;
+bool PacketXorDivider::set_frame_class(uint8_t frame_class, uint32_t xor_stride, uint32_t deadline_millisecond)
+{
+    return nullptr != m_divider && m_divider->set_frame_class(frame_class, xor_stride, deadline_millisecond);
 }
 
-static bool packet_unify(const void * data, uint32_t size, groups_t & groups, std::list<std::vector<uint8_t>> & dst_list, uint32_t max_delay_microseconds, double fault_tolerance_rate, decode_callback_t decode_callback, void * user_data)
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, std::list<std::vector<uint8_t>> & dst_list)
 {
-    if (nullptr != data && 0 != size)
-    {
-        if (!insert_group_block(data, size, groups, max_delay_microseconds))
-        {
-            return false;
-        }
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, frame_class, dst_list, nullptr, nullptr);
+}
 
-        group_t & group = groups.group_items[groups.new_group_index];
-        if (group.head.recv_block_count != group.head.need_block_count && groups.new_group_index == groups.min_group_index)
-        {
-            return false;
-        }
-    }
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, encode_callback_t encode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, frame_class, dst_list, encode_callback, user_data);
+}
 
-    const std::size_t old_dst_list_size = dst_list.size();
+bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class, PacketBatch & dst_batch)
+{
+    return nullptr != m_divider && m_divider->encode(src_data, src_size, frame_class, dst_batch);
+}
 
-    uint32_t current_seconds = 0;
-    uint32_t current_microseconds = 0;
-    get_current_time(current_seconds, current_microseconds);
-    std::list<decode_timer_t>::iterator iter = groups.decode_timer_list.begin();
-    while (groups.decode_timer_list.end() != iter)
+bool PacketXorDivider::encode_object(const uint8_t * object_data, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data)
+{
+    return nullptr != m_divider && m_divider->encode_object(object_data, -1, object_size, window_size, encode_callback, user_data);
+}
+
+bool PacketXorDivider::encode_object(int file_descriptor, uint64_t object_size, uint32_t window_size, encode_callback_t encode_callback, void * user_data)
+{
+    return nullptr != m_divider && m_divider->encode_object(nullptr, file_descriptor, object_size, window_size, encode_callback, user_data);
+}
+
+bool PacketXorDivider::set_retransmit(uint32_t cache_block_count)
+{
+    return nullptr != m_divider && m_divider->set_retransmit(cache_block_count);
+}
+
+bool PacketXorDivider::resend(const uint8_t * nack_data, uint32_t nack_size, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return nullptr != m_divider && m_divider->resend(nack_data, nack_size, dst_list, nullptr, nullptr);
+}
+
+bool PacketXorDivider::resend(const uint8_t * nack_data, uint32_t nack_size, encode_callback_t encode_callback, void * user_data)
+{
+    std::list<std::vector<uint8_t>> dst_list;
+    return nullptr != m_divider && m_divider->resend(nack_data, nack_size, dst_list, encode_callback, user_data);
+}
+
+bool PacketXorDivider::resend(const uint8_t * nack_data, uint32_t nack_size, PacketBatch & dst_batch)
+{
+    return nullptr != m_divider && m_divider->resend(nack_data, nack_size, dst_batch);
+}
+
+void PacketXorDivider::reset()
+{
+    if (nullptr != m_divider)
     {
-        const decode_timer_t & decode_timer = *iter;
-        group_t & group = groups.group_items[decode_timer.group_index];
-        if (group.head.recv_block_count == group.head.need_block_count)
-        {
-            group.body.group_data.resize(group.head.group_bytes, 0x0);
-            if (nullptr != decode_callback)
-            {
-                (*decode_callback)(user_data, &group.body.group_data[0], static_cast<uint32_t>(group.body.group_data.size()));
-            }
-            dst_list.emplace_back(std::move(group.body.group_data));
-            groups.group_items.erase(decode_timer.group_index);
-            groups.min_group_index = decode_timer.group_index + 1;
-            iter = groups.decode_timer_list.erase(iter);
-        }
-        else if ((decode_timer.decode_seconds < current_seconds) || (decode_timer.decode_seconds == current_seconds && decode_timer.decode_microseconds < current_microseconds))
-        {
-            if (fault_tolerance_rate > 0.0 && fault_tolerance_rate < 1.0)
-            {
-                if (group.head.recv_block_count >= static_cast<uint32_t>(group.head.need_block_count * (1.0 - fault_tolerance_rate)))
-                {
-                    group.body.group_data.resize(group.head.group_bytes, 0x0);
-                    if (nullptr != decode_callback)
-                    {
-                        (*decode_callback)(user_data, &group.body.group_data[0], static_cast<uint32_t>(group.body.group_data.size()));
-                    }
-                    dst_list.emplace_back(std::move(group.body.group_data));
-                }
-            }
-            groups.group_items.erase(decode_timer.group_index);
-            groups.min_group_index = decode_timer.group_index + 1;
-            iter = groups.decode_timer_list.erase(iter);
-        }
-        else
-        {
-            break;
-        }
+        m_divider->reset();
     }
+}
 
-    const std::size_t new_dst_list_size = dst_list.size();
+PacketXorUnifier::PacketXorUnifier()
+    : m_unifier(nullptr)
+{
 
-    remove_expired_blocks(groups);
+}
 
-    return new_dst_list_size > old_dst_list_size;
+PacketXorUnifier::~PacketXorUnifier()
+{
+    exit();
 }
 
-class PacketXorDividerImpl
+bool PacketXorUnifier::init(uint32_t expire_millisecond, double fault_tolerance_rate, uint64_t memory_budget_bytes, uint32_t max_group_bytes)
 {
-public:
-    PacketXorDividerImpl(uint32_t max_block_size, bool use_xor);
-    PacketXorDividerImpl(const PacketXorDividerImpl &) = delete;
-    PacketXorDividerImpl(PacketXorDividerImpl &&) = delete;
-    PacketXorDividerImpl & operator = (const PacketXorDividerImpl &) = delete;
-    PacketXorDividerImpl & operator = (PacketXorDividerImpl &&) = delete;
-    ~PacketXorDividerImpl();
+    exit();
 
-public:
-    bool encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
-    bool encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data);
+    return nullptr != (m_unifier = new PacketXorUnifierImpl(expire_millisecond * 1000, fault_tolerance_rate, memory_budget_bytes, max_group_bytes));
+}
 
-public:
-    void reset();
+void PacketXorUnifier::exit()
+{
+    if (nullptr != m_unifier)
+    {
+        delete m_unifier;
+        m_unifier = nullptr;
+    }
+}
 
-private:
-    const uint32_t      m_max_block_size;
-    const bool          m_use_xor;
+bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+{
+    return nullptr != m_unifier && m_unifier->decode(src_data, src_size, dst_list);
+}
 
-private:
-    uint64_t            m_group_index;
-};
+bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data)
+{
+    return nullptr != m_unifier && m_unifier->decode(src_data, src_size, decode_callback, user_data);
+}
 
-PacketXorDividerImpl::PacketXorDividerImpl(uint32_t max_block_size, bool use_xor)
-    : m_max_block_size(std::max<uint32_t>(max_block_size, sizeof(block_t) + 1))
-    , m_use_xor(use_xor)
-    , m_group_index(0)
+bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, PacketBatch & dst_batch)
 {
+    return nullptr != m_unifier && m_unifier->decode(src_data, src_size, dst_batch);
+}
 
+bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, reserve_callback_t reserve_callback, decode_callback_t commit_callback, void * user_data)
+{
+    return nullptr != m_unifier && nullptr != reserve_callback && nullptr != commit_callback && m_unifier->decode(src_data, src_size, reserve_callback, commit_callback, user_data);
 }
 
-PacketXorDividerImpl::~PacketXorDividerImpl()
+bool PacketXorUnifier::decode(const PacketBatch & src_batch, const std::vector<block_view_t> & block_views, PacketBatch & dst_batch)
 {
+    return nullptr != m_unifier && m_unifier->decode(src_batch, block_views, dst_batch);
+}
 
+uint64_t PacketXorUnifier::next_deadline() const
+{
+    return nullptr != m_unifier ? m_unifier->next_deadline() : 0;
 }
 
-bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+bool PacketXorUnifier::poll(uint64_t now_microsecond, std::list<std::vector<uint8_t>> & dst_list)
 {
-    return packet_divide(src_data, src_size, m_max_block_size, m_use_xor, m_group_index, dst_list, nullptr, nullptr);
+    return nullptr != m_unifier && m_unifier->poll(now_microsecond, dst_list);
 }
 
-bool PacketXorDividerImpl::encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data)
+bool PacketXorUnifier::poll(uint64_t now_microsecond, decode_callback_t decode_callback, void * user_data)
 {
-    std::list<std::vector<uint8_t>> dst_list;
-    return packet_divide(src_data, src_size, m_max_block_size, m_use_xor, m_group_index, dst_list, encode_callback, user_data);
+    return nullptr != m_unifier && m_unifier->poll(now_microsecond, decode_callback, user_data);
 }
 
-void PacketXorDividerImpl::reset()
+bool PacketXorUnifier::poll(uint64_t now_microsecond, PacketBatch & dst_batch)
 {
-    m_group_index = 0;
+    return nullptr != m_unifier && m_unifier->poll(now_microsecond, dst_batch);
 }
 
-class PacketXorUnifierImpl
+uint64_t PacketXorUnifier::current_microsecond()
 {
-public:
-    PacketXorUnifierImpl(uint32_t max_delay_microseconds = 1000 * 15, double fault_tolerance_rate = 0.0);
-    PacketXorUnifierImpl(const PacketXorUnifierImpl &) = delete;
-    PacketXorUnifierImpl(PacketXorUnifierImpl &&) = delete;
-    PacketXorUnifierImpl & operator = (const PacketXorUnifierImpl &) = delete;
-    PacketXorUnifierImpl & operator = (PacketXorUnifierImpl &&) = delete;
-    ~PacketXorUnifierImpl();
+    return PacketXorUnifierImpl::current_microseconds();
+}
 
-public:
-    bool decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list);
-    bool decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data);
+bool PacketXorUnifier::recognizable(const uint8_t * src_data, uint32_t src_size)
+{
+    return PacketXorUnifierImpl::recognizable(src_data, src_size);
+}
 
-public:
-    static bool recognizable(const uint8_t * src_data, uint32_t src_size);
+std::size_t PacketXorUnifier::classify(const PacketBatch & src_batch, std::vector<uint64_t> & valid_mask, std::vector<block_view_t> & block_views)
+{
+    return PacketXorUnifierImpl::classify(src_batch, valid_mask, block_views);
+}
 
-public:
-    void reset();
+bool PacketXorUnifier::set_nack(uint32_t nack_delay_millisecond, nack_callback_t nack_callback, void * user_data)
+{
+    return nullptr != m_unifier && m_unifier->set_nack(nack_delay_millisecond * 1000, nack_callback, user_data);
+}
 
-private:
-    const uint32_t      m_max_delay_microseconds;
-    const double        m_fault_tolerance_rate;
+bool PacketXorUnifier::set_trace(const char * trace_path, bool with_payload)
+{
+    return nullptr != m_unifier && m_unifier->set_trace(trace_path, with_payload);
+}
 
-private:
-    groups_t            m_groups;
-};
+bool PacketXorUnifier::replay(const char * trace_path, decode_callback_t decode_callback, void * user_data, replay_stats_t & stats)
+{
+    return nullptr != m_unifier && m_unifier->replay(trace_path, decode_callback, user_data, stats);
+}
 
-PacketXorUnifierImpl::PacketXorUnifierImpl(uint32_t max_delay_microseconds, double fault_tolerance_rate)
-    : m_max_delay_microseconds(std::max<uint32_t>(max_delay_microseconds, 500))
-    , m_fault_tolerance_rate(std::max<double>(std::min<double>(fault_tolerance_rate, 1.0), 0.0))
-    , m_groups()
+bool PacketXorUnifier::set_object_output(const char * file_path, object_callback_t object_callback, void * user_data)
 {
+    return nullptr != m_unifier && m_unifier->set_object_output(file_path, object_callback, user_data);
+}
 
+bool PacketXorUnifier::set_progress(progress_callback_t progress_callback, complete_callback_t complete_callback, void * user_data)
+{
+    return nullptr != m_unifier && m_unifier->set_progress(progress_callback, complete_callback, user_data);
 }
 
-PacketXorUnifierImpl::~PacketXorUnifierImpl()
+bool PacketXorUnifier::set_adaptive_expiry(uint32_t min_expire_millisecond, uint32_t max_expire_millisecond, double jitter_factor)
 {
+    return nullptr != m_unifier && m_unifier->set_adaptive_expiry(min_expire_millisecond * 1000, max_expire_millisecond * 1000, jitter_factor);
+}
 
+bool PacketXorUnifier::set_lazy_recovery(bool lazy_recovery, uint32_t margin_millisecond)
+{
+    return nullptr != m_unifier && m_unifier->set_lazy_recovery(lazy_recovery, margin_millisecond * 1000);
 }
 
-bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+void PacketXorUnifier::get_stats(unifier_stats_t & stats) const
 {
-    return packet_unify(src_data, src_size, m_groups, dst_list, m_max_delay_microseconds, m_fault_tolerance_rate, nullptr, nullptr);
+    if (nullptr != m_unifier)
+    {
+        m_unifier->get_stats(stats);
+    }
+    else
+    {
+        memset(&stats, 0x0, sizeof(stats));
+    }
 }
 
-bool PacketXorUnifierImpl::decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data)
+bool PacketXorUnifier::get_path_stats(uint32_t path_index, path_stats_t & stats) const
 {
-    std::list<std::vector<uint8_t>> dst_list;
-    return packet_unify(src_data, src_size, m_groups, dst_list, m_max_delay_microseconds, m_fault_tolerance_rate, decode_callback, user_data);
+    if (nullptr != m_unifier)
+    {
+        return m_unifier->get_path_stats(path_index, stats);
+    }
+    memset(&stats, 0x0, sizeof(stats));
+    return false;
 }
 
-bool PacketXorUnifierImpl::recognizable(const uint8_t * src_data, uint32_t src_size)
+void PacketXorUnifier::recycle(std::vector<uint8_t> && frame)
 {
-    return check_package(src_data, src_size);
+    if (nullptr != m_unifier)
+    {
+        m_unifier->recycle(std::move(frame));
+    }
 }
 
-void PacketXorUnifierImpl::reset()
+void PacketXorUnifier::reset()
 {
-    m_groups.reset();
+    if (nullptr != m_unifier)
+    {
+        m_unifier->reset();
+    }
 }
 
-PacketXorDivider::PacketXorDivider()
-    : m_divider(nullptr)
+PacketXorStriper::PacketXorStriper()
+    : m_striper(nullptr)
 {
 
 }
 
-PacketXorDivider::~PacketXorDivider()
+PacketXorStriper::~PacketXorStriper()
 {
     exit();
 }
 
-bool PacketXorDivider::init(uint32_t max_block_size, bool use_xor)
+bool PacketXorStriper::init(uint32_t path_count, const uint32_t * path_weights, stripe_callback_t stripe_callback, void * user_data)
 {
     exit();
 
-    return nullptr != (m_divider = new PacketXorDividerImpl(max_block_size, use_xor));
+    if (0 == path_count || path_count > s_max_path_count || nullptr == stripe_callback)
+    {
+        return false;
+    }
+
+    return nullptr != (m_striper = new PacketXorStriperImpl(path_count, path_weights, stripe_callback, user_data));
 }
 
-void PacketXorDivider::exit()
+void PacketXorStriper::exit()
 {
-    if (nullptr != m_divider)
+    if (nullptr != m_striper)
     {
-        delete m_divider;
-        m_divider = nullptr;
+        delete m_striper;
+        m_striper = nullptr;
     }
 }
 
-bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+bool PacketXorStriper::set_path_weight(uint32_t path_index, uint32_t path_weight)
 {
-    return nullptr != m_divider && m_divider->encode(src_data, src_size, dst_list);
+    return nullptr != m_striper && m_striper->set_path_weight(path_index, path_weight);
 }
 
-bool PacketXorDivider::encode(const uint8_t * src_data, uint32_t src_size, encode_callback_t encode_callback, void * user_data)
+bool PacketXorStriper::set_path_capacity(uint32_t path_index, double path_capacity)
 {
-    return nullptr != m_divider && m_divider->encode(src_data, src_size, encode_callback, user_data);
+    return nullptr != m_striper && m_striper->set_path_capacity(path_index, path_capacity);
 }
 
-void PacketXorDivider::reset()
+bool PacketXorStriper::send(const uint8_t * src_data, uint32_t src_size)
 {
-    if (nullptr != m_divider)
+    return nullptr != m_striper && m_striper->send(src_data, src_size);
+}
+
+bool PacketXorStriper::send(const PacketBatch & src_batch)
+{
+    if (nullptr == m_striper)
     {
-        m_divider->reset();
+        return false;
+    }
+
+    bool ret = true;
+    for (std::size_t packet_index = 0; packet_index < src_batch.size(); ++packet_index)
+    {
+        ret = m_striper->send(src_batch.data(packet_index), src_batch.length(packet_index)) && ret;
     }
+    return ret;
 }
 
-PacketXorUnifier::PacketXorUnifier()
-    : m_unifier(nullptr)
+void PacketXorStriper::stripe_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    reinterpret_cast<PacketXorStriper *>(user_data)->send(dst_data, dst_size);
+}
+
+void PacketXorStriper::reset()
+{
+    if (nullptr != m_striper)
+    {
+        m_striper->reset();
+    }
+}
+
+PacketXorFanout::PacketXorFanout()
+    : m_fanout(nullptr)
 {
 
 }
 
-PacketXorUnifier::~PacketXorUnifier()
+PacketXorFanout::~PacketXorFanout()
 {
     exit();
 }
 
-bool PacketXorUnifier::init(uint32_t expire_millisecond, double fault_tolerance_rate)
+bool PacketXorFanout::init(uint32_t max_block_size, bool use_xor, bool use_crc)
 {
     exit();
 
-    return nullptr != (m_unifier = new PacketXorUnifierImpl(expire_millisecond * 1000, fault_tolerance_rate));
+    return nullptr != (m_fanout = new PacketXorFanoutImpl(max_block_size, use_xor, use_crc));
 }
 
-void PacketXorUnifier::exit()
+void PacketXorFanout::exit()
 {
-    if (nullptr != m_unifier)
+    if (nullptr != m_fanout)
     {
-        delete m_unifier;
-        m_unifier = nullptr;
+        delete m_fanout;
+        m_fanout = nullptr;
     }
 }
 
-bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, std::list<std::vector<uint8_t>> & dst_list)
+bool PacketXorFanout::add_session(uint32_t session_id)
 {
-    return nullptr != m_unifier && m_unifier->decode(src_data, src_size, dst_list);
+    return nullptr != m_fanout && m_fanout->add_session(session_id);
 }
 
-bool PacketXorUnifier::decode(const uint8_t * src_data, uint32_t src_size, decode_callback_t decode_callback, void * user_data)
+bool PacketXorFanout::remove_session(uint32_t session_id)
 {
-    return nullptr != m_unifier && m_unifier->decode(src_data, src_size, decode_callback, user_data);
+    return nullptr != m_fanout && m_fanout->remove_session(session_id);
 }
 
-bool PacketXorUnifier::recognizable(const uint8_t * src_data, uint32_t src_size)
+bool PacketXorFanout::encode(const uint8_t * src_data, uint32_t src_size)
 {
-    return PacketXorUnifierImpl::recognizable(src_data, src_size);
+    return nullptr != m_fanout && m_fanout->encode(src_data, src_size);
 }
 
-void PacketXorUnifier::reset()
+bool PacketXorFanout::emit(uint32_t session_id, std::vector<fanout_packet_t> & dst_packets)
 {
-    if (nullptr != m_unifier)
+    return nullptr != m_fanout && m_fanout->emit(session_id, dst_packets);
+}
+
+bool PacketXorFanout::emit(fanout_callback_t fanout_callback, void * user_data)
+{
+    return nullptr != m_fanout && nullptr != fanout_callback && m_fanout->emit(fanout_callback, user_data);
+}
+
+void PacketXorFanout::reset()
+{
+    if (nullptr != m_fanout)
     {
-        m_unifier->reset();
+        m_fanout->reset();
     }
 }
@@ -0,0 +1,584 @@
+/********************************************************
+ * Description : packet xor shared memory frame ring
+ * Author      : yanrk
+ * Email       : yanrkchina@163.com
+ * Version     : 1.0
+ * History     :
+ * Copyright(C): 2021-2022
+ ********************************************************/
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/eventfd.h>
+    #include <linux/memfd.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif // __linux__
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "packet_xor_shm.h"
+
+#ifdef __linux__
+
+static const uint32_t s_shm_magic = 0x50585348;
+static const uint32_t s_shm_version = 1;
+static const uint32_t s_shm_slot_align = 64;
+
+struct shm_ring_t
+{
+    uint32_t                            magic;
+    uint32_t                            version;
+    uint32_t                            slot_count;
+    uint32_t                            slot_size;
+    uint32_t                            slot_stride;
+    uint32_t                            reserved;
+    uint64_t                            slots_offset;
+    alignas(64) std::atomic<uint64_t>   head;
+    alignas(64) std::atomic<uint64_t>   tail;
+    alignas(64) std::atomic<uint32_t>   waiting;
+};
+
+struct shm_slot_t
+{
+    uint64_t                            sequence;
+    uint32_t                            frame_bytes;
+    uint32_t                            reserved;
+};
+
+static int create_memory_fd(const char * name, uint32_t flags)
+{
+    return static_cast<int>(syscall(__NR_memfd_create, name, flags));
+}
+
+static uint64_t round_up(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+class PacketXorShmWriterImpl
+{
+public:
+    explicit PacketXorShmWriterImpl(PacketXorUnifier * unifier);
+    PacketXorShmWriterImpl(const PacketXorShmWriterImpl &) = delete;
+    PacketXorShmWriterImpl(PacketXorShmWriterImpl &&) = delete;
+    PacketXorShmWriterImpl & operator = (const PacketXorShmWriterImpl &) = delete;
+    PacketXorShmWriterImpl & operator = (PacketXorShmWriterImpl &&) = delete;
+    ~PacketXorShmWriterImpl();
+
+public:
+    bool init(uint32_t slot_count, uint32_t slot_size);
+    int memory_fd() const;
+    int event_fd() const;
+
+public:
+    bool decode(const uint8_t * src_data, uint32_t src_size);
+
+public:
+    void get_stats(shm_stats_t & stats) const;
+
+private:
+    static uint8_t * reserve_slot(void * user_data, uint32_t dst_size);
+    static void commit_slot(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+
+private:
+    shm_slot_t * slot_at(uint64_t sequence) const;
+
+private:
+    PacketXorUnifier          * m_unifier;
+    int                         m_memory_fd;
+    int                         m_event_fd;
+    uint8_t                   * m_memory;
+    size_t                      m_memory_bytes;
+    shm_ring_t                * m_ring;
+    bool                        m_published;
+    shm_stats_t                 m_stats;
+};
+
+PacketXorShmWriterImpl::PacketXorShmWriterImpl(PacketXorUnifier * unifier)
+    : m_unifier(unifier)
+    , m_memory_fd(-1)
+    , m_event_fd(-1)
+    , m_memory(nullptr)
+    , m_memory_bytes(0)
+    , m_ring(nullptr)
+    , m_published(false)
+    , m_stats()
+{
+    memset(&m_stats, 0x0, sizeof(m_stats));
+}
+
+PacketXorShmWriterImpl::~PacketXorShmWriterImpl()
+{
+    if (nullptr != m_memory)
+    {
+        munmap(m_memory, m_memory_bytes);
+    }
+    if (m_event_fd >= 0)
+    {
+        close(m_event_fd);
+    }
+    if (m_memory_fd >= 0)
+    {
+        close(m_memory_fd);
+    }
+}
+
+bool PacketXorShmWriterImpl::init(uint32_t slot_count, uint32_t slot_size)
+{
+    const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    const uint64_t slots_offset = round_up(sizeof(shm_ring_t), page_size);
+    const uint64_t slot_stride = round_up(sizeof(shm_slot_t) + static_cast<uint64_t>(slot_size), s_shm_slot_align);
+    if (slot_stride > 0xFFFFFFFF)
+    {
+        return false;
+    }
+    m_memory_bytes = static_cast<size_t>(slots_offset + slot_stride * slot_count);
+
+    m_memory_fd = create_memory_fd("packet_xor_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (m_memory_fd < 0 || ftruncate(m_memory_fd, static_cast<off_t>(m_memory_bytes)) < 0)
+    {
+        return false;
+    }
+#ifdef F_ADD_SEALS
+    fcntl(m_memory_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+#endif // F_ADD_SEALS
+
+    void * memory = mmap(nullptr, m_memory_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_memory_fd, 0);
+    if (MAP_FAILED == memory)
+    {
+        return false;
+    }
+    m_memory = reinterpret_cast<uint8_t *>(memory);
+
+    m_event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_event_fd < 0)
+    {
+        return false;
+    }
+
+    m_ring = new (m_memory) shm_ring_t;
+    m_ring->magic = s_shm_magic;
+    m_ring->version = s_shm_version;
+    m_ring->slot_count = slot_count;
+    m_ring->slot_size = slot_size;
+    m_ring->slot_stride = static_cast<uint32_t>(slot_stride);
+    m_ring->reserved = 0;
+    m_ring->slots_offset = slots_offset;
+    m_ring->head.store(0, std::memory_order_relaxed);
+    m_ring->tail.store(0, std::memory_order_relaxed);
+    m_ring->waiting.store(0, std::memory_order_seq_cst);
+
+    return m_ring->head.is_lock_free() && m_ring->waiting.is_lock_free();
+}
+
+int PacketXorShmWriterImpl::memory_fd() const
+{
+    return m_memory_fd;
+}
+
+int PacketXorShmWriterImpl::event_fd() const
+{
+    return m_event_fd;
+}
+
+shm_slot_t * PacketXorShmWriterImpl::slot_at(uint64_t sequence) const
+{
+    return reinterpret_cast<shm_slot_t *>(m_memory + m_ring->slots_offset + (sequence % m_ring->slot_count) * m_ring->slot_stride);
+}
+
+uint8_t * PacketXorShmWriterImpl::reserve_slot(void * user_data, uint32_t dst_size)
+{
+    PacketXorShmWriterImpl * writer = reinterpret_cast<PacketXorShmWriterImpl *>(user_data);
+    shm_ring_t * ring = writer->m_ring;
+    if (dst_size > ring->slot_size)
+    {
+        writer->m_stats.oversize_frames += 1;
+        return nullptr;
+    }
+
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= ring->slot_count)
+    {
+        writer->m_stats.dropped_frames += 1;
+        return nullptr;
+    }
+
+    return reinterpret_cast<uint8_t *>(writer->slot_at(head)) + sizeof(shm_slot_t);
+}
+
+void PacketXorShmWriterImpl::commit_slot(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    PacketXorShmWriterImpl * writer = reinterpret_cast<PacketXorShmWriterImpl *>(user_data);
+    shm_ring_t * ring = writer->m_ring;
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    shm_slot_t * slot = writer->slot_at(head);
+    (void)dst_data;
+    slot->sequence = head;
+    slot->frame_bytes = dst_size;
+    ring->head.store(head + 1, std::memory_order_seq_cst);
+
+    writer->m_published = true;
+    writer->m_stats.published_frames += 1;
+    writer->m_stats.published_bytes += dst_size;
+}
+
+bool PacketXorShmWriterImpl::decode(const uint8_t * src_data, uint32_t src_size)
+{
+    const bool decoded = m_unifier->decode(src_data, src_size, &PacketXorShmWriterImpl::reserve_slot, &PacketXorShmWriterImpl::commit_slot, this);
+
+    if (m_published)
+    {
+        m_published = false;
+        if (0 != m_ring->waiting.load(std::memory_order_seq_cst))
+        {
+            m_ring->waiting.store(0, std::memory_order_seq_cst);
+            const uint64_t wakeup = 1;
+            if (sizeof(wakeup) == write(m_event_fd, &wakeup, sizeof(wakeup)))
+            {
+                m_stats.wakeups += 1;
+            }
+        }
+    }
+
+    return decoded;
+}
+
+void PacketXorShmWriterImpl::get_stats(shm_stats_t & stats) const
+{
+    stats = m_stats;
+}
+
+class PacketXorShmReaderImpl
+{
+public:
+    PacketXorShmReaderImpl();
+    PacketXorShmReaderImpl(const PacketXorShmReaderImpl &) = delete;
+    PacketXorShmReaderImpl(PacketXorShmReaderImpl &&) = delete;
+    PacketXorShmReaderImpl & operator = (const PacketXorShmReaderImpl &) = delete;
+    PacketXorShmReaderImpl & operator = (PacketXorShmReaderImpl &&) = delete;
+    ~PacketXorShmReaderImpl();
+
+public:
+    bool init(int memory_fd, int event_fd);
+
+public:
+    bool acquire(shm_frame_t & frame);
+    bool release();
+    bool wait(uint32_t wait_millisecond);
+
+private:
+    int                         m_memory_fd;
+    int                         m_event_fd;
+    shm_ring_t                * m_ring;
+    size_t                      m_ring_bytes;
+    const uint8_t             * m_slots;
+    size_t                      m_slots_bytes;
+    uint64_t                    m_read_sequence;
+};
+
+PacketXorShmReaderImpl::PacketXorShmReaderImpl()
+    : m_memory_fd(-1)
+    , m_event_fd(-1)
+    , m_ring(nullptr)
+    , m_ring_bytes(0)
+    , m_slots(nullptr)
+    , m_slots_bytes(0)
+    , m_read_sequence(0)
+{
+
+}
+
+PacketXorShmReaderImpl::~PacketXorShmReaderImpl()
+{
+    if (nullptr != m_slots)
+    {
+        munmap(const_cast<uint8_t *>(m_slots), m_slots_bytes);
+    }
+    if (nullptr != m_ring)
+    {
+        munmap(m_ring, m_ring_bytes);
+    }
+    if (m_event_fd >= 0)
+    {
+        close(m_event_fd);
+    }
+    if (m_memory_fd >= 0)
+    {
+        close(m_memory_fd);
+    }
+}
+
+bool PacketXorShmReaderImpl::init(int memory_fd, int event_fd)
+{
+    m_memory_fd = fcntl(memory_fd, F_DUPFD_CLOEXEC, 0);
+    m_event_fd = fcntl(event_fd, F_DUPFD_CLOEXEC, 0);
+    if (m_memory_fd < 0 || m_event_fd < 0)
+    {
+        return false;
+    }
+
+    struct stat memory_stat;
+    const uint64_t page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    m_ring_bytes = static_cast<size_t>(round_up(sizeof(shm_ring_t), page_size));
+    if (fstat(m_memory_fd, &memory_stat) < 0 || static_cast<uint64_t>(memory_stat.st_size) < m_ring_bytes)
+    {
+        return false;
+    }
+
+    void * ring = mmap(nullptr, m_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_memory_fd, 0);
+    if (MAP_FAILED == ring)
+    {
+        return false;
+    }
+    m_ring = reinterpret_cast<shm_ring_t *>(ring);
+
+    if (s_shm_magic != m_ring->magic || s_shm_version != m_ring->version || m_ring_bytes != m_ring->slots_offset || 0 == m_ring->slot_count || m_ring->slot_stride < sizeof(shm_slot_t) + m_ring->slot_size)
+    {
+        return false;
+    }
+
+    m_slots_bytes = static_cast<size_t>(static_cast<uint64_t>(m_ring->slot_count) * m_ring->slot_stride);
+    if (static_cast<uint64_t>(memory_stat.st_size) < m_ring->slots_offset + m_slots_bytes)
+    {
+        return false;
+    }
+
+    void * slots = mmap(nullptr, m_slots_bytes, PROT_READ, MAP_SHARED, m_memory_fd, static_cast<off_t>(m_ring->slots_offset));
+    if (MAP_FAILED == slots)
+    {
+        return false;
+    }
+    m_slots = reinterpret_cast<const uint8_t *>(slots);
+
+    m_read_sequence = m_ring->tail.load(std::memory_order_acquire);
+
+    return true;
+}
+
+bool PacketXorShmReaderImpl::acquire(shm_frame_t & frame)
+{
+    if (m_read_sequence == m_ring->head.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    const shm_slot_t * slot = reinterpret_cast<const shm_slot_t *>(m_slots + (m_read_sequence % m_ring->slot_count) * m_ring->slot_stride);
+    frame.data = reinterpret_cast<const uint8_t *>(slot) + sizeof(shm_slot_t);
+    frame.size = slot->frame_bytes;
+    frame.sequence = slot->sequence;
+    ++m_read_sequence;
+
+    return true;
+}
+
+bool PacketXorShmReaderImpl::release()
+{
+    const uint64_t tail = m_ring->tail.load(std::memory_order_relaxed);
+    if (tail == m_read_sequence)
+    {
+        return false;
+    }
+
+    m_ring->tail.store(tail + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool PacketXorShmReaderImpl::wait(uint32_t wait_millisecond)
+{
+    if (m_read_sequence != m_ring->head.load(std::memory_order_acquire))
+    {
+        return true;
+    }
+
+    m_ring->waiting.store(1, std::memory_order_seq_cst);
+    if (m_read_sequence == m_ring->head.load(std::memory_order_seq_cst))
+    {
+        struct pollfd event_poll;
+        event_poll.fd = m_event_fd;
+        event_poll.events = POLLIN;
+        event_poll.revents = 0;
+        while (poll(&event_poll, 1, static_cast<int>(wait_millisecond)) < 0 && EINTR == errno)
+        {
+        }
+
+        uint64_t wakeup = 0;
+        while (sizeof(wakeup) == read(m_event_fd, &wakeup, sizeof(wakeup)))
+        {
+        }
+    }
+    m_ring->waiting.store(0, std::memory_order_seq_cst);
+
+    return m_read_sequence != m_ring->head.load(std::memory_order_acquire);
+}
+
+#else
+
+class PacketXorShmWriterImpl
+{
+public:
+    int memory_fd() const { return -1; }
+    int event_fd() const { return -1; }
+    bool decode(const uint8_t *, uint32_t) { return false; }
+    void get_stats(shm_stats_t & stats) const { memset(&stats, 0x0, sizeof(stats)); }
+};
+
+class PacketXorShmReaderImpl
+{
+public:
+    bool acquire(shm_frame_t &) { return false; }
+    bool release() { return false; }
+    bool wait(uint32_t) { return false; }
+};
+
+#endif // __linux__
+
+PacketXorShmWriter::PacketXorShmWriter()
+    : m_writer(nullptr)
+{
+
+}
+
+PacketXorShmWriter::~PacketXorShmWriter()
+{
+    exit();
+}
+
+bool PacketXorShmWriter::supported()
+{
+#ifdef __linux__
+    const int memory_fd = create_memory_fd("packet_xor_shm", MFD_CLOEXEC);
+    if (memory_fd < 0)
+    {
+        return false;
+    }
+    close(memory_fd);
+    return true;
+#else
+    return false;
+#endif // __linux__
+}
+
+bool PacketXorShmWriter::init(PacketXorUnifier * unifier, uint32_t slot_count, uint32_t slot_size)
+{
+    exit();
+
+    if (nullptr == unifier || 0 == slot_count || 0 == slot_size)
+    {
+        return false;
+    }
+
+#ifdef __linux__
+    m_writer = new PacketXorShmWriterImpl(unifier);
+    if (!m_writer->init(slot_count, slot_size))
+    {
+        exit();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif // __linux__
+}
+
+void PacketXorShmWriter::exit()
+{
+    if (nullptr != m_writer)
+    {
+        delete m_writer;
+        m_writer = nullptr;
+    }
+}
+
+int PacketXorShmWriter::memory_fd() const
+{
+    return nullptr != m_writer ? m_writer->memory_fd() : -1;
+}
+
+int PacketXorShmWriter::event_fd() const
+{
+    return nullptr != m_writer ? m_writer->event_fd() : -1;
+}
+
+bool PacketXorShmWriter::decode(const uint8_t * src_data, uint32_t src_size)
+{
+    return nullptr != m_writer && m_writer->decode(src_data, src_size);
+}
+
+void PacketXorShmWriter::get_stats(shm_stats_t & stats) const
+{
+    if (nullptr != m_writer)
+    {
+        m_writer->get_stats(stats);
+    }
+    else
+    {
+        memset(&stats, 0x0, sizeof(stats));
+    }
+}
+
+PacketXorShmReader::PacketXorShmReader()
+    : m_reader(nullptr)
+{
+
+}
+
+PacketXorShmReader::~PacketXorShmReader()
+{
+    exit();
+}
+
+bool PacketXorShmReader::init(int memory_fd, int event_fd)
+{
+    exit();
+
+    if (memory_fd < 0 || event_fd < 0)
+    {
+        return false;
+    }
+
+#ifdef __linux__
+    m_reader = new PacketXorShmReaderImpl();
+    if (!m_reader->init(memory_fd, event_fd))
+    {
+        exit();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif // __linux__
+}
+
+void PacketXorShmReader::exit()
+{
+    if (nullptr != m_reader)
+    {
+        delete m_reader;
+        m_reader = nullptr;
+    }
+}
+
+bool PacketXorShmReader::acquire(shm_frame_t & frame)
+{
+    return nullptr != m_reader && m_reader->acquire(frame);
+}
+
+bool PacketXorShmReader::release()
+{
+    return nullptr != m_reader && m_reader->release();
+}
+
+bool PacketXorShmReader::wait(uint32_t wait_millisecond)
+{
+    return nullptr != m_reader && m_reader->wait(wait_millisecond);
+}
@@ -0,0 +1,836 @@
+/********************************************************
+ * Description : packet xor io_uring udp engine
+ * Author      : yanrk
+ * Email       : yanrkchina@163.com
+ * Version     : 1.0
+ * History     :
+ * Copyright(C): 2021-2022
+ ********************************************************/
+
+#ifdef __linux__
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/syscall.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <linux/io_uring.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif // __linux__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "packet_xor_uring.h"
+
+#ifdef __linux__
+
+static const uint64_t s_recv_user_data = 0;
+static const uint16_t s_recv_buffer_group = 0;
+
+static int io_uring_setup(uint32_t entries, struct io_uring_params * params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int ring_fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, const void * arg, size_t arg_size)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+}
+
+static int io_uring_register(int ring_fd, uint32_t opcode, const void * arg, uint32_t arg_count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, arg_count));
+}
+
+static bool parse_address(const char * host, uint16_t port, struct sockaddr_in & address)
+{
+    memset(&address, 0x0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (nullptr == host || '\0' == host[0])
+    {
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+    return 1 == inet_pton(AF_INET, host, &address.sin_addr);
+}
+
+class PacketXorUringImpl
+{
+public:
+    PacketXorUringImpl(PacketXorDivider * divider, PacketXorUnifier * unifier, decode_callback_t decode_callback, void * user_data);
+    PacketXorUringImpl(const PacketXorUringImpl &) = delete;
+    PacketXorUringImpl(PacketXorUringImpl &&) = delete;
+    PacketXorUringImpl & operator = (const PacketXorUringImpl &) = delete;
+    PacketXorUringImpl & operator = (PacketXorUringImpl &&) = delete;
+    ~PacketXorUringImpl();
+
+public:
+    bool init(const char * local_host, uint16_t local_port, uint32_t queue_depth, uint32_t buffer_count, uint32_t buffer_size, bool zero_copy);
+    uint16_t local_port() const;
+    bool set_peer(const char * peer_host, uint16_t peer_port);
+
+public:
+    bool send(const uint8_t * src_data, uint32_t src_size, int frame_class);
+    int run(uint32_t wait_millisecond);
+
+public:
+    void get_stats(uring_stats_t & stats) const;
+
+private:
+    static void send_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size);
+
+private:
+    bool init_ring(uint32_t queue_depth);
+    bool init_recv_buffers(uint32_t buffer_count, uint32_t buffer_size);
+    bool init_send_slots(uint32_t slot_count, uint32_t slot_size, bool zero_copy);
+    struct io_uring_sqe * acquire_sqe();
+    bool submit(uint32_t wait_count, uint32_t wait_millisecond);
+    bool arm_recv();
+    void recycle_recv_buffer(uint16_t buffer_id);
+    int reap_completions();
+    void handle_recv(const struct io_uring_cqe & cqe);
+    void handle_send(const struct io_uring_cqe & cqe);
+
+private:
+    PacketXorDivider          * m_divider;
+    PacketXorUnifier          * m_unifier;
+    decode_callback_t           m_decode_callback;
+    void                      * m_user_data;
+
+private:
+    int                         m_socket;
+    struct sockaddr_in          m_peer_address;
+    bool                        m_peer_valid;
+
+private:
+    int                         m_ring_fd;
+    void                      * m_ring_memory;
+    size_t                      m_ring_bytes;
+    struct io_uring_sqe       * m_sqes;
+    size_t                      m_sqe_bytes;
+    uint32_t                  * m_sq_head;
+    uint32_t                  * m_sq_tail;
+    uint32_t                  * m_sq_array;
+    uint32_t                    m_sq_mask;
+    uint32_t                    m_sq_entries;
+    uint32_t                    m_sq_local_tail;
+    uint32_t                    m_sq_pending;
+    uint32_t                  * m_cq_head;
+    uint32_t                  * m_cq_tail;
+    struct io_uring_cqe       * m_cqes;
+    uint32_t                    m_cq_mask;
+
+private:
+    struct io_uring_buf_ring  * m_buf_ring;
+    size_t                      m_buf_ring_bytes;
+    uint32_t                    m_buf_ring_mask;
+    uint16_t                    m_buf_ring_tail;
+    std::vector<uint8_t>        m_recv_buffers;
+    uint32_t                    m_recv_buffer_size;
+    struct msghdr               m_recv_msghdr;
+    bool                        m_recv_armed;
+
+private:
+    uint8_t                   * m_send_memory;
+    size_t                      m_send_memory_bytes;
+    uint32_t                    m_send_slot_size;
+    std::vector<uint32_t>       m_send_free_slots;
+    std::vector<struct msghdr>  m_send_msghdrs;
+    std::vector<struct iovec>   m_send_iovecs;
+    bool                        m_zero_copy;
+    bool                        m_send_failed;
+    struct io_uring_sqe       * m_send_last_sqe;
+
+private:
+    uring_stats_t               m_stats;
+};
+
+PacketXorUringImpl::PacketXorUringImpl(PacketXorDivider * divider, PacketXorUnifier * unifier, decode_callback_t decode_callback, void * user_data)
+    : m_divider(divider)
+    , m_unifier(unifier)
+    , m_decode_callback(decode_callback)
+    , m_user_data(user_data)
+    , m_socket(-1)
+    , m_peer_address()
+    , m_peer_valid(false)
+    , m_ring_fd(-1)
+    , m_ring_memory(MAP_FAILED)
+    , m_ring_bytes(0)
+    , m_sqes(reinterpret_cast<struct io_uring_sqe *>(MAP_FAILED))
+    , m_sqe_bytes(0)
+    , m_sq_head(nullptr)
+    , m_sq_tail(nullptr)
+    , m_sq_array(nullptr)
+    , m_sq_mask(0)
+    , m_sq_entries(0)
+    , m_sq_local_tail(0)
+    , m_sq_pending(0)
+    , m_cq_head(nullptr)
+    , m_cq_tail(nullptr)
+    , m_cqes(nullptr)
+    , m_cq_mask(0)
+    , m_buf_ring(reinterpret_cast<struct io_uring_buf_ring *>(MAP_FAILED))
+    , m_buf_ring_bytes(0)
+    , m_buf_ring_mask(0)
+    , m_buf_ring_tail(0)
+    , m_recv_buffers()
+    , m_recv_buffer_size(0)
+    , m_recv_msghdr()
+    , m_recv_armed(false)
+    , m_send_memory(reinterpret_cast<uint8_t *>(MAP_FAILED))
+    , m_send_memory_bytes(0)
+    , m_send_slot_size(0)
+    , m_send_free_slots()
+    , m_send_msghdrs()
+    , m_send_iovecs()
+    , m_zero_copy(false)
+    , m_send_failed(false)
+    , m_send_last_sqe(nullptr)
+    , m_stats()
+{
+    memset(&m_stats, 0x0, sizeof(m_stats));
+}
+
+PacketXorUringImpl::~PacketXorUringImpl()
+{
+    if (-1 != m_ring_fd)
+    {
+        close(m_ring_fd);
+    }
+    if (-1 != m_socket)
+    {
+        close(m_socket);
+    }
+    if (MAP_FAILED != m_send_memory)
+    {
+        munmap(m_send_memory, m_send_memory_bytes);
+    }
+    if (MAP_FAILED != m_buf_ring)
+    {
+        munmap(m_buf_ring, m_buf_ring_bytes);
+    }
+    if (MAP_FAILED != m_sqes)
+    {
+        munmap(m_sqes, m_sqe_bytes);
+    }
+    if (MAP_FAILED != m_ring_memory)
+    {
+        munmap(m_ring_memory, m_ring_bytes);
+    }
+}
+
+bool PacketXorUringImpl::init(const char * local_host, uint16_t local_port, uint32_t queue_depth, uint32_t buffer_count, uint32_t buffer_size, bool zero_copy)
+{
+    if (nullptr == m_divider && nullptr == m_unifier)
+    {
+        return false;
+    }
+
+    if (0 == queue_depth || 0 == buffer_count || buffer_count > 0x8000 || buffer_size <= sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in))
+    {
+        return false;
+    }
+
+    struct sockaddr_in local_address;
+    if (!parse_address(local_host, local_port, local_address))
+    {
+        return false;
+    }
+
+    m_socket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (-1 == m_socket)
+    {
+        return false;
+    }
+
+    int socket_buffer_bytes = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(buffer_count) * buffer_size * 2, 0x7FFFFFFF));
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &socket_buffer_bytes, sizeof(socket_buffer_bytes));
+    setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &socket_buffer_bytes, sizeof(socket_buffer_bytes));
+
+    if (0 != bind(m_socket, reinterpret_cast<struct sockaddr *>(&local_address), sizeof(local_address)))
+    {
+        return false;
+    }
+
+    if (!init_ring(queue_depth))
+    {
+        return false;
+    }
+
+    if (nullptr != m_unifier && (!init_recv_buffers(buffer_count, buffer_size) || !arm_recv() || !submit(0, 0)))
+    {
+        return false;
+    }
+
+    if (nullptr != m_divider && !init_send_slots(buffer_count, buffer_size, zero_copy))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+bool PacketXorUringImpl::init_ring(uint32_t queue_depth)
+{
+    struct io_uring_params params;
+    memset(&params, 0x0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = queue_depth * 4;
+
+    m_ring_fd = io_uring_setup(queue_depth, &params);
+    if (m_ring_fd < 0)
+    {
+        m_ring_fd = -1;
+        return false;
+    }
+
+    if (0 == (params.features & IORING_FEAT_SINGLE_MMAP) || 0 == (params.features & IORING_FEAT_EXT_ARG))
+    {
+        return false;
+    }
+
+    const size_t sq_ring_bytes = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    const size_t cq_ring_bytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    m_ring_bytes = std::max<size_t>(sq_ring_bytes, cq_ring_bytes);
+    m_ring_memory = mmap(nullptr, m_ring_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQ_RING);
+    if (MAP_FAILED == m_ring_memory)
+    {
+        return false;
+    }
+
+    m_sqe_bytes = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = reinterpret_cast<struct io_uring_sqe *>(mmap(nullptr, m_sqe_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring_fd, IORING_OFF_SQES));
+    if (MAP_FAILED == m_sqes)
+    {
+        return false;
+    }
+
+    uint8_t * ring = reinterpret_cast<uint8_t *>(m_ring_memory);
+    m_sq_head = reinterpret_cast<uint32_t *>(ring + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<uint32_t *>(ring + params.sq_off.tail);
+    m_sq_array = reinterpret_cast<uint32_t *>(ring + params.sq_off.array);
+    m_sq_mask = *reinterpret_cast<uint32_t *>(ring + params.sq_off.ring_mask);
+    m_sq_entries = params.sq_entries;
+    m_sq_local_tail = *m_sq_tail;
+    m_cq_head = reinterpret_cast<uint32_t *>(ring + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<uint32_t *>(ring + params.cq_off.tail);
+    m_cqes = reinterpret_cast<struct io_uring_cqe *>(ring + params.cq_off.cqes);
+    m_cq_mask = *reinterpret_cast<uint32_t *>(ring + params.cq_off.ring_mask);
+
+    return true;
+}
+
+bool PacketXorUringImpl::init_recv_buffers(uint32_t buffer_count, uint32_t buffer_size)
+{
+    uint32_t ring_entries = 1;
+    while (ring_entries < buffer_count)
+    {
+        ring_entries <<= 1;
+    }
+
+    m_buf_ring_bytes = ring_entries * sizeof(struct io_uring_buf);
+    m_buf_ring = reinterpret_cast<struct io_uring_buf_ring *>(mmap(nullptr, m_buf_ring_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (MAP_FAILED == m_buf_ring)
+    {
+        return false;
+    }
+
+    struct io_uring_buf_reg buf_reg;
+    memset(&buf_reg, 0x0, sizeof(buf_reg));
+    buf_reg.ring_addr = reinterpret_cast<uint64_t>(m_buf_ring);
+    buf_reg.ring_entries = ring_entries;
+    buf_reg.bgid = s_recv_buffer_group;
+    if (0 != io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &buf_reg, 1))
+    {
+        return false;
+    }
+
+    m_buf_ring_mask = ring_entries - 1;
+    m_buf_ring_tail = 0;
+    m_recv_buffer_size = buffer_size;
+    m_recv_buffers.resize(static_cast<size_t>(buffer_count) * buffer_size);
+    for (uint32_t buffer_id = 0; buffer_id < buffer_count; ++buffer_id)
+    {
+        recycle_recv_buffer(static_cast<uint16_t>(buffer_id));
+    }
+
+    memset(&m_recv_msghdr, 0x0, sizeof(m_recv_msghdr));
+    m_recv_msghdr.msg_namelen = sizeof(struct sockaddr_in);
+
+    return true;
+}
+
+bool PacketXorUringImpl::init_send_slots(uint32_t slot_count, uint32_t slot_size, bool zero_copy)
+{
+    m_send_slot_size = slot_size;
+    m_send_memory_bytes = static_cast<size_t>(slot_count) * slot_size;
+    m_send_memory = reinterpret_cast<uint8_t *>(mmap(nullptr, m_send_memory_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (MAP_FAILED == m_send_memory)
+    {
+        return false;
+    }
+
+    m_send_free_slots.reserve(slot_count);
+    for (uint32_t slot_index = slot_count; slot_index > 0; --slot_index)
+    {
+        m_send_free_slots.push_back(slot_index - 1);
+    }
+
+    m_send_msghdrs.resize(slot_count);
+    m_send_iovecs.resize(slot_count);
+    for (uint32_t slot_index = 0; slot_index < slot_count; ++slot_index)
+    {
+        struct msghdr & send_msghdr = m_send_msghdrs[slot_index];
+        memset(&send_msghdr, 0x0, sizeof(send_msghdr));
+        send_msghdr.msg_name = &m_peer_address;
+        send_msghdr.msg_namelen = sizeof(m_peer_address);
+        send_msghdr.msg_iov = &m_send_iovecs[slot_index];
+        send_msghdr.msg_iovlen = 1;
+        m_send_iovecs[slot_index].iov_base = m_send_memory + static_cast<size_t>(slot_index) * slot_size;
+        m_send_iovecs[slot_index].iov_len = 0;
+    }
+
+    if (!zero_copy)
+    {
+        return true;
+    }
+
+    std::vector<uint8_t> probe_memory(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0x0);
+    struct io_uring_probe * probe = reinterpret_cast<struct io_uring_probe *>(&probe_memory[0]);
+    if (0 != io_uring_register(m_ring_fd, IORING_REGISTER_PROBE, probe, 256))
+    {
+        return true;
+    }
+    if (probe->last_op < IORING_OP_SEND_ZC || 0 == (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED))
+    {
+        return true;
+    }
+
+    struct iovec send_iovec;
+    send_iovec.iov_base = m_send_memory;
+    send_iovec.iov_len = m_send_memory_bytes;
+    m_zero_copy = (0 == io_uring_register(m_ring_fd, IORING_REGISTER_BUFFERS, &send_iovec, 1));
+
+    return true;
+}
+
+uint16_t PacketXorUringImpl::local_port() const
+{
+    struct sockaddr_in local_address;
+    socklen_t address_size = sizeof(local_address);
+    if (0 != getsockname(m_socket, reinterpret_cast<struct sockaddr *>(&local_address), &address_size))
+    {
+        return 0;
+    }
+    return ntohs(local_address.sin_port);
+}
+
+bool PacketXorUringImpl::set_peer(const char * peer_host, uint16_t peer_port)
+{
+    m_peer_valid = (nullptr != peer_host && parse_address(peer_host, peer_port, m_peer_address));
+    return m_peer_valid;
+}
+
+struct io_uring_sqe * PacketXorUringImpl::acquire_sqe()
+{
+    const uint32_t sq_head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    if (m_sq_local_tail - sq_head >= m_sq_entries)
+    {
+        if (!submit(0, 0))
+        {
+            return nullptr;
+        }
+        if (m_sq_local_tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) >= m_sq_entries)
+        {
+            return nullptr;
+        }
+    }
+
+    const uint32_t sq_index = m_sq_local_tail & m_sq_mask;
+    struct io_uring_sqe * sqe = &m_sqes[sq_index];
+    memset(sqe, 0x0, sizeof(*sqe));
+    m_sq_array[sq_index] = sq_index;
+    ++m_sq_local_tail;
+    ++m_sq_pending;
+
+    return sqe;
+}
+
+bool PacketXorUringImpl::submit(uint32_t wait_count, uint32_t wait_millisecond)
+{
+    if (0 == m_sq_pending && 0 == wait_count)
+    {
+        return true;
+    }
+
+    __atomic_store_n(m_sq_tail, m_sq_local_tail, __ATOMIC_RELEASE);
+
+    struct __kernel_timespec wait_timespec;
+    wait_timespec.tv_sec = wait_millisecond / 1000;
+    wait_timespec.tv_nsec = static_cast<long long>(wait_millisecond % 1000) * 1000000;
+
+    struct io_uring_getevents_arg getevents_arg;
+    memset(&getevents_arg, 0x0, sizeof(getevents_arg));
+    getevents_arg.ts = reinterpret_cast<uint64_t>(&wait_timespec);
+
+    const uint32_t flags = (0 != wait_count ? IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG : 0);
+    const int submitted = io_uring_enter(m_ring_fd, m_sq_pending, wait_count, flags, (0 != wait_count ? &getevents_arg : nullptr), (0 != wait_count ? sizeof(getevents_arg) : 0));
+    if (submitted < 0)
+    {
+        if (ETIME != errno && EINTR != errno && EBUSY != errno && EAGAIN != errno)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        m_sq_pending -= std::min<uint32_t>(static_cast<uint32_t>(submitted), m_sq_pending);
+    }
+
+    return true;
+}
+
+bool PacketXorUringImpl::arm_recv()
+{
+    struct io_uring_sqe * sqe = acquire_sqe();
+    if (nullptr == sqe)
+    {
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = m_socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&m_recv_msghdr);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_TRUNC;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = s_recv_buffer_group;
+    sqe->user_data = s_recv_user_data;
+
+    m_recv_armed = true;
+
+    return true;
+}
+
+void PacketXorUringImpl::recycle_recv_buffer(uint16_t buffer_id)
+{
+    /* io_uring_buf_ring::bufs sits behind an empty struct, which is not zero sized in c++ */
+    struct io_uring_buf * buf = reinterpret_cast<struct io_uring_buf *>(m_buf_ring) + (m_buf_ring_tail & m_buf_ring_mask);
+    buf->addr = reinterpret_cast<uint64_t>(&m_recv_buffers[static_cast<size_t>(buffer_id) * m_recv_buffer_size]);
+    buf->len = m_recv_buffer_size;
+    buf->bid = buffer_id;
+    ++m_buf_ring_tail;
+    __atomic_store_n(&m_buf_ring->tail, m_buf_ring_tail, __ATOMIC_RELEASE);
+}
+
+void PacketXorUringImpl::handle_recv(const struct io_uring_cqe & cqe)
+{
+    if (0 == (cqe.flags & IORING_CQE_F_MORE))
+    {
+        m_recv_armed = false;
+    }
+
+    if (0 == (cqe.flags & IORING_CQE_F_BUFFER))
+    {
+        if (cqe.res < 0 && -ENOBUFS == cqe.res)
+        {
+            ++m_stats.recv_dropped;
+        }
+        return;
+    }
+
+    const uint16_t buffer_id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    const uint8_t * buffer = &m_recv_buffers[static_cast<size_t>(buffer_id) * m_recv_buffer_size];
+    const size_t payload_offset = sizeof(struct io_uring_recvmsg_out) + m_recv_msghdr.msg_namelen + m_recv_msghdr.msg_controllen;
+    if (cqe.res >= 0 && static_cast<size_t>(cqe.res) >= payload_offset)
+    {
+        struct io_uring_recvmsg_out recvmsg_out;
+        memcpy(&recvmsg_out, buffer, sizeof(recvmsg_out));
+        if (0 != (recvmsg_out.flags & MSG_TRUNC))
+        {
+            ++m_stats.recv_dropped;
+        }
+        else
+        {
+            const uint32_t payload_size = std::min<uint32_t>(recvmsg_out.payloadlen, static_cast<uint32_t>(cqe.res - payload_offset));
+            ++m_stats.recv_blocks;
+            m_unifier->decode(buffer + payload_offset, payload_size, m_decode_callback, m_user_data);
+        }
+    }
+
+    recycle_recv_buffer(buffer_id);
+}
+
+void PacketXorUringImpl::handle_send(const struct io_uring_cqe & cqe)
+{
+    if (0 == (cqe.flags & IORING_CQE_F_NOTIF))
+    {
+        if (cqe.res < 0)
+        {
+            ++m_stats.send_errors;
+        }
+        if (0 != (cqe.flags & IORING_CQE_F_MORE))
+        {
+            return;
+        }
+    }
+
+    m_send_free_slots.push_back(static_cast<uint32_t>(cqe.user_data - 1));
+}
+
+int PacketXorUringImpl::reap_completions()
+{
+    int reaped = 0;
+    uint32_t cq_head = *m_cq_head;
+    const uint32_t cq_tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    for (; cq_head != cq_tail; ++cq_head, ++reaped)
+    {
+        const struct io_uring_cqe & cqe = m_cqes[cq_head & m_cq_mask];
+        if (s_recv_user_data == cqe.user_data)
+        {
+            handle_recv(cqe);
+        }
+        else
+        {
+            handle_send(cqe);
+        }
+    }
+    __atomic_store_n(m_cq_head, cq_head, __ATOMIC_RELEASE);
+
+    return reaped;
+}
+
+void PacketXorUringImpl::send_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    PacketXorUringImpl * uring = reinterpret_cast<PacketXorUringImpl *>(user_data);
+    if (uring->m_send_failed)
+    {
+        return;
+    }
+
+    if (dst_size > uring->m_send_slot_size)
+    {
+        uring->m_send_failed = true;
+        return;
+    }
+
+    while (uring->m_send_free_slots.empty())
+    {
+        if (!uring->submit(1, 1000))
+        {
+            uring->m_send_failed = true;
+            return;
+        }
+        uring->reap_completions();
+    }
+
+    struct io_uring_sqe * sqe = uring->acquire_sqe();
+    if (nullptr == sqe)
+    {
+        uring->m_send_failed = true;
+        return;
+    }
+
+    const uint32_t slot_index = uring->m_send_free_slots.back();
+    uring->m_send_free_slots.pop_back();
+
+    uint8_t * slot_data = uring->m_send_memory + static_cast<size_t>(slot_index) * uring->m_send_slot_size;
+    memcpy(slot_data, dst_data, dst_size);
+
+    sqe->fd = uring->m_socket;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = static_cast<uint64_t>(slot_index) + 1;
+    if (uring->m_zero_copy)
+    {
+        sqe->opcode = IORING_OP_SEND_ZC;
+        sqe->addr = reinterpret_cast<uint64_t>(slot_data);
+        sqe->len = dst_size;
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = 0;
+        sqe->addr2 = reinterpret_cast<uint64_t>(&uring->m_peer_address);
+        sqe->addr_len = sizeof(uring->m_peer_address);
+        ++uring->m_stats.zero_copy_sends;
+    }
+    else
+    {
+        uring->m_send_iovecs[slot_index].iov_len = dst_size;
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->addr = reinterpret_cast<uint64_t>(&uring->m_send_msghdrs[slot_index]);
+        sqe->len = 1;
+    }
+
+    uring->m_send_last_sqe = sqe;
+    ++uring->m_stats.send_blocks;
+}
+
+bool PacketXorUringImpl::send(const uint8_t * src_data, uint32_t src_size, int frame_class)
+{
+    if (nullptr == m_divider || !m_peer_valid)
+    {
+        return false;
+    }
+
+    m_send_failed = false;
+    m_send_last_sqe = nullptr;
+
+    const bool encoded = (frame_class < 0 ? m_divider->encode(src_data, src_size, send_block, this) : m_divider->encode(src_data, src_size, static_cast<uint8_t>(frame_class), send_block, this));
+    if (nullptr != m_send_last_sqe)
+    {
+        m_send_last_sqe->flags &= ~IOSQE_IO_LINK;
+    }
+
+    return submit(0, 0) && encoded && !m_send_failed;
+}
+
+int PacketXorUringImpl::run(uint32_t wait_millisecond)
+{
+    if (nullptr != m_divider && m_peer_valid)
+    {
+        m_send_last_sqe = nullptr;
+        m_divider->poll(send_block, this);
+        if (nullptr != m_send_last_sqe)
+        {
+            m_send_last_sqe->flags &= ~IOSQE_IO_LINK;
+        }
+    }
+
+    if (nullptr != m_unifier && !m_recv_armed)
+    {
+        ++m_stats.recv_rearms;
+        if (!arm_recv())
+        {
+            return -1;
+        }
+    }
+
+    const bool ready = (*m_cq_head != __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE));
+    if (!submit((ready || 0 == wait_millisecond) ? 0 : 1, wait_millisecond))
+    {
+        return -1;
+    }
+
+    const int reaped = reap_completions();
+
+    if (nullptr != m_unifier)
+    {
+        m_unifier->decode(nullptr, 0, m_decode_callback, m_user_data);
+    }
+
+    return reaped;
+}
+
+void PacketXorUringImpl::get_stats(uring_stats_t & stats) const
+{
+    stats = m_stats;
+}
+
+#else
+
+class PacketXorUringImpl
+{
+public:
+    uint16_t local_port() const { return 0; }
+    bool set_peer(const char *, uint16_t) { return false; }
+    bool send(const uint8_t *, uint32_t, int) { return false; }
+    int run(uint32_t) { return -1; }
+    void get_stats(uring_stats_t & stats) const { memset(&stats, 0x0, sizeof(stats)); }
+};
+
+#endif // __linux__
+
+PacketXorUring::PacketXorUring()
+    : m_uring(nullptr)
+{
+
+}
+
+PacketXorUring::~PacketXorUring()
+{
+    exit();
+}
+
+bool PacketXorUring::supported()
+{
+#ifdef __linux__
+    struct io_uring_params params;
+    memset(&params, 0x0, sizeof(params));
+    const int ring_fd = io_uring_setup(1, &params);
+    if (ring_fd < 0)
+    {
+        return false;
+    }
+    close(ring_fd);
+    return 0 != (params.features & IORING_FEAT_EXT_ARG);
+#else
+    return false;
+#endif // __linux__
+}
+
+bool PacketXorUring::init(const char * local_host, uint16_t local_port, PacketXorDivider * divider, PacketXorUnifier * unifier, decode_callback_t decode_callback, void * user_data, uint32_t queue_depth, uint32_t buffer_count, uint32_t buffer_size, bool zero_copy)
+{
+    exit();
+
+#ifdef __linux__
+    m_uring = new PacketXorUringImpl(divider, unifier, decode_callback, user_data);
+    if (!m_uring->init(local_host, local_port, queue_depth, buffer_count, buffer_size, zero_copy))
+    {
+        exit();
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif // __linux__
+}
+
+void PacketXorUring::exit()
+{
+    if (nullptr != m_uring)
+    {
+        delete m_uring;
+        m_uring = nullptr;
+    }
+}
+
+uint16_t PacketXorUring::local_port() const
+{
+    return nullptr != m_uring ? m_uring->local_port() : 0;
+}
+
+bool PacketXorUring::set_peer(const char * peer_host, uint16_t peer_port)
+{
+    return nullptr != m_uring && m_uring->set_peer(peer_host, peer_port);
+}
+
+bool PacketXorUring::send(const uint8_t * src_data, uint32_t src_size)
+{
+    return nullptr != m_uring && m_uring->send(src_data, src_size, -1);
+}
+
+bool PacketXorUring::send(const uint8_t * src_data, uint32_t src_size, uint8_t frame_class)
+{
+    return nullptr != m_uring && m_uring->send(src_data, src_size, frame_class);
+}
+
+int PacketXorUring::run(uint32_t wait_millisecond)
+{
+    return nullptr != m_uring ? m_uring->run(wait_millisecond) : -1;
+}
+
+void PacketXorUring::get_stats(uring_stats_t & stats) const
+{
+    if (nullptr != m_uring)
+    {
+        m_uring->get_stats(stats);
+    }
+    else
+    {
+        memset(&stats, 0x0, sizeof(stats));
+    }
+}
@@ -11,12 +11,23 @@
     #include <windows.h>
 #else
     #include <sys/time.h>
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <arpa/inet.h>
+    #include <sys/wait.h>
+    #include <fcntl.h>
+    #include <unistd.h>
 #endif // _MSC_VER
 
 #include <ctime>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <algorithm>
 #include "packet_xor.h"
+#include "packet_xor_uring.h"
+#include "packet_xor_shm.h"
+#include "packet_xor_coro.h"
 
 static void get_system_time(int32_t & seconds, int32_t & microseconds)
 {
@@ -33,6 +44,15 @@ static void get_system_time(int32_t & seconds, int32_t & microseconds)
 #endif // _MSC_VER
 }
 
+static void sleep_millisecond(uint32_t milliseconds)
+{
+#ifdef _MSC_VER
+    Sleep(milliseconds);
+#else
+    usleep(milliseconds * 1000);
+#endif // _MSC_VER
+}
+
 int test_1()
 {
     std::vector<uint8_t> src_data(307608, 0x0);
@@ -237,18 +257,2196 @@ int test_2()
     return 0;
 }
 
-int main()
+int test_3()
 {
-    if (0 != test_1())
+    std::vector<uint8_t> src_data(307608, 0x0);
+
+    srand(static_cast<uint32_t>(time(nullptr)));
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        std::list<std::vector<uint8_t>> src_list;
+
+        PacketXorDivider divider;
+        if (!divider.init(1100, true, true))
+        {
+            return 1;
+        }
+
+        if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+        {
+            return 2;
+        }
+
+        uint64_t corrupt_count = 0;
+        uint64_t packet_index = 0;
+        for (std::list<std::vector<uint8_t>>::iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+        {
+            if (0 == packet_index++ % 5)
+            {
+                std::vector<uint8_t> & data = *iter;
+                data[36 + rand() % (data.size() - 36)] ^= static_cast<uint8_t>(1 + rand() % 255);
+                ++corrupt_count;
+            }
+        }
+
+        std::list<std::vector<uint8_t>> dst_list;
+
+        PacketXorUnifier unifier;
+        if (!unifier.init(30))
+        {
+            return 3;
+        }
+
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+        {
+            const std::vector<uint8_t> & data = *iter;
+            unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+        }
+
+        unifier_stats_t stats = { 0x0 };
+        unifier.get_stats(stats);
+        if (stats.checksum_error_blocks != corrupt_count)
+        {
+            return 4;
+        }
+
+        if (1 != dst_list.size())
+        {
+            return 5;
+        }
+
+        if (dst_list.front() != src_data)
+        {
+            return 6;
+        }
+    }
+
+    return 0;
+}
+
+int test_4()
+{
+    PacketXorUnifier unifier;
+    if (!unifier.init(30, 0.0, 1024 * 1024, 512 * 1024))
     {
         return 1;
     }
 
-    if (0 != test_2())
+    std::vector<uint8_t> forged_data(28 + 0xF0, 0x0);
+    const uint8_t forged_head[28] = { 0, 0, 0, 0, 0, 0, 0, 0, 0xe9, 0, 0, 0, 0x01, 0x11, 0x11, 0x11, 0, 0, 0, 0xF0, 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xF0 };
+    std::copy(forged_head, forged_head + sizeof(forged_head), forged_data.begin());
+
+    std::list<std::vector<uint8_t>> dst_list;
+    if (!PacketXorUnifier::recognizable(&forged_data[0], static_cast<uint32_t>(forged_data.size())) || unifier.decode(&forged_data[0], static_cast<uint32_t>(forged_data.size()), dst_list))
+    {
+        return 2;
+    }
+
+    unifier_stats_t stats = { 0x0 };
+    unifier.get_stats(stats);
+    if (1 != stats.rejected_groups || stats.memory_used_bytes > 1024)
+    {
+        return 3;
+    }
+
+    std::vector<uint8_t> src_data(307608, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    if (!divider.init(1100, true))
+    {
+        return 4;
+    }
+
+    for (int i = 0; i < 20; ++i)
+    {
+        std::list<std::vector<uint8_t>> src_list;
+        if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+        {
+            return 5;
+        }
+
+        src_list.resize(src_list.size() / 2);
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+        {
+            const std::vector<uint8_t> & data = *iter;
+            unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+
+            unifier.get_stats(stats);
+            if (stats.memory_used_bytes > stats.memory_budget_bytes)
+            {
+                return 6;
+            }
+        }
+    }
+
+    if (0 == stats.evicted_groups || !dst_list.empty())
+    {
+        return 7;
+    }
+
+    return 0;
+}
+
+int test_5()
+{
+    std::vector<uint8_t> src_data(307608, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    if (!divider.init(1100, false))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> src_list;
+    if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+    {
+        return 2;
+    }
+
+    PacketXorUnifier unifier;
+    if (!unifier.init(1, 0.5))
+    {
+        return 3;
+    }
+
+    const uint32_t block_bytes = 1100 - 28;
+    const uint32_t lost_block_index = 10;
+
+    std::list<std::vector<uint8_t>> dst_list;
+    uint32_t block_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter, ++block_index)
+    {
+        if (lost_block_index == block_index)
+        {
+            unifier_stats_t stats = { 0x0 };
+            unifier.get_stats(stats);
+            if (stats.memory_used_bytes > 4 * 16 * 1024)
+            {
+                return 4;
+            }
+            continue;
+        }
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    sleep_millisecond(5);
+    unifier.decode(nullptr, 0, dst_list);
+
+    if (1 != dst_list.size() || dst_list.front().size() != src_data.size())
+    {
+        return 5;
+    }
+
+    std::vector<uint8_t> & dst_data = dst_list.front();
+    for (uint32_t index = 0; index < dst_data.size(); ++index)
+    {
+        const bool lost = (index / block_bytes == lost_block_index);
+        if ((lost && 0 != dst_data[index]) || (!lost && dst_data[index] != src_data[index]))
+        {
+            return 6;
+        }
+    }
+
+    return 0;
+}
+
+int test_6()
+{
+    PacketXorDivider divider;
+    if (!divider.init(1100, true) || !divider.set_aggregation(200, 5))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> msg_list;
+    std::list<std::vector<uint8_t>> src_list;
+    for (int i = 0; i < 10000; ++i)
+    {
+        std::vector<uint8_t> msg_data(0 == i % 1000 ? 3000 : 1 + rand() % 200, 0x0);
+        for (std::vector<uint8_t>::iterator iter = msg_data.begin(); msg_data.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        if (!divider.encode(&msg_data[0], static_cast<uint32_t>(msg_data.size()), src_list))
+        {
+            return 2;
+        }
+
+        msg_list.emplace_back(std::move(msg_data));
+    }
+    divider.flush(src_list);
+
+    if (src_list.size() * 4 > msg_list.size())
+    {
+        return 3;
+    }
+
+    PacketXorUnifier unifier;
+    if (!unifier.init(30))
+    {
+        return 4;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+    {
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    if (dst_list != msg_list)
+    {
+        return 5;
+    }
+
+    PacketXorDivider plain_divider;
+    std::vector<uint8_t> plain_data(40, 0x5a);
+    std::list<std::vector<uint8_t>> plain_list;
+    if (!plain_divider.init(1100, true) || !plain_divider.encode(&plain_data[0], static_cast<uint32_t>(plain_data.size()), plain_list) || 2 != plain_list.size() || 1100 != plain_list.front().size() || 1100 != plain_list.back().size())
+    {
+        return 6;
+    }
+
+    return 0;
+}
+
+static void nack_callback(void * user_data, const uint8_t * nack_data, uint32_t nack_size)
+{
+    std::list<std::vector<uint8_t>> & nack_list = *reinterpret_cast<std::list<std::vector<uint8_t>> *>(user_data);
+    nack_list.emplace_back(nack_data, nack_data + nack_size);
+}
+
+int test_7()
+{
+    std::vector<uint8_t> src_data(307608, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    if (!divider.init(1100, false) || !divider.set_retransmit(1024))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> src_list;
+    if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+    {
+        return 2;
+    }
+
+    std::list<std::vector<uint8_t>> nack_list;
+    PacketXorUnifier unifier;
+    if (!unifier.init(200) || !unifier.set_nack(20, nack_callback, &nack_list))
+    {
+        return 3;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    uint32_t lost_count = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+    {
+        if (0 == rand() % 10)
+        {
+            ++lost_count;
+            continue;
+        }
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    if (0 == lost_count || !dst_list.empty())
+    {
+        return 4;
+    }
+
+    sleep_millisecond(25);
+    unifier.decode(nullptr, 0, dst_list);
+
+    unifier_stats_t stats = { 0x0 };
+    unifier.get_stats(stats);
+    if (nack_list.empty() || stats.nack_blocks != lost_count)
+    {
+        return 5;
+    }
+
+    std::list<std::vector<uint8_t>> resend_list;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = nack_list.begin(); nack_list.end() != iter; ++iter)
+    {
+        const std::vector<uint8_t> & data = *iter;
+        if (!divider.resend(&data[0], static_cast<uint32_t>(data.size()), resend_list))
+        {
+            return 6;
+        }
+    }
+
+    if (resend_list.size() != lost_count)
+    {
+        return 7;
+    }
+
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = resend_list.begin(); resend_list.end() != iter; ++iter)
+    {
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    if (1 != dst_list.size() || dst_list.front() != src_data)
+    {
+        return 8;
+    }
+
+    return 0;
+}
+
+int test_8()
+{
+    std::vector<uint8_t> src_data(307608, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    if (!divider.init(1100, false) || !divider.set_frame_class(0, 0, 5) || !divider.set_frame_class(1, 1, 1000))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> low_list;
+    std::list<std::vector<uint8_t>> high_list;
+    if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), 0, low_list) || !divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), 1, high_list))
     {
         return 2;
     }
 
+    if (2 * low_list.size() - 1 != high_list.size())
+    {
+        return 3;
+    }
+
+    PacketXorUnifier unifier;
+    if (!unifier.init(1000))
+    {
+        return 4;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    low_list.pop_back();
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = low_list.begin(); low_list.end() != iter; ++iter)
+    {
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    uint32_t packet_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = high_list.begin(); high_list.end() != iter; ++iter)
+    {
+        if (0 == packet_index++ % 6)
+        {
+            continue;
+        }
+        const std::vector<uint8_t> & data = *iter;
+        unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+    }
+
+    if (!dst_list.empty())
+    {
+        return 5;
+    }
+
+    sleep_millisecond(10);
+    unifier.decode(nullptr, 0, dst_list);
+
+    if (1 != dst_list.size() || dst_list.front() != src_data)
+    {
+        return 6;
+    }
+
+    return 0;
+}
+
+int test_9()
+{
+    std::vector<uint8_t> src_data(56000, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    if (!divider.init(1100, false))
+    {
+        return 1;
+    }
+
+    PacketXorUnifier unifier;
+    if (!unifier.init(1000, 0.5) || !unifier.set_adaptive_expiry(2, 500, 4.0))
+    {
+        return 2;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    for (uint32_t frame_index = 0; frame_index < 20; ++frame_index)
+    {
+        std::list<std::vector<uint8_t>> src_list;
+        if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+        {
+            return 3;
+        }
+        if (19 == frame_index)
+        {
+            src_list.pop_back();
+        }
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+        {
+            const std::vector<uint8_t> & data = *iter;
+            unifier.decode(&data[0], static_cast<uint32_t>(data.size()), dst_list);
+        }
+    }
+
+    if (19 != dst_list.size())
+    {
+        return 4;
+    }
+
+    sleep_millisecond(10);
+    unifier.decode(nullptr, 0, dst_list);
+
+    if (20 != dst_list.size() || dst_list.back().size() != src_data.size())
+    {
+        return 5;
+    }
+
+    unifier_stats_t stats;
+    unifier.get_stats(stats);
+    if (stats.spread_average_microseconds > 2000.0)
+    {
+        return 6;
+    }
+
+    return 0;
+}
+
+struct frame_counter_t
+{
+    uint32_t    frame_size;
+    uint32_t    frame_count;
+    uint32_t    error_count;
+};
+
+static void count_frame(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    frame_counter_t * counter = reinterpret_cast<frame_counter_t *>(user_data);
+    ++counter->frame_count;
+    if (dst_size != counter->frame_size)
+    {
+        ++counter->error_count;
+    }
+}
+
+int test_10()
+{
+#ifdef __linux__
+    if (!PacketXorUring::supported())
+    {
+        return 0;
+    }
+
+    std::vector<uint8_t> src_data(32000, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    const uint32_t frame_count = 2000;
+
+    {
+        PacketXorDivider divider;
+        PacketXorUnifier unifier;
+        if (!divider.init(1100, false) || !unifier.init(100))
+        {
+            return 1;
+        }
+
+        frame_counter_t counter = { static_cast<uint32_t>(src_data.size()), 0, 0 };
+        PacketXorUring uring;
+        if (!uring.init("127.0.0.1", 0, &divider, &unifier, count_frame, &counter) || !uring.set_peer("127.0.0.1", uring.local_port()))
+        {
+            return 2;
+        }
+
+        int32_t s1 = 0;
+        int32_t m1 = 0;
+        get_system_time(s1, m1);
+
+        for (uint32_t frame_index = 0; frame_index < frame_count; ++frame_index)
+        {
+            if (!uring.send(&src_data[0], static_cast<uint32_t>(src_data.size())))
+            {
+                return 3;
+            }
+            for (uint32_t retry = 0; counter.frame_count <= frame_index && retry < 100; ++retry)
+            {
+                if (uring.run(10) < 0)
+                {
+                    return 4;
+                }
+            }
+        }
+
+        int32_t s2 = 0;
+        int32_t m2 = 0;
+        get_system_time(s2, m2);
+
+        int32_t delta12 = (s2 - s1) * 1000 + (m2 - m1) / 1000;
+        std::cout << "uring use time " << delta12 << "ms" << std::endl;
+
+        if (frame_count != counter.frame_count || 0 != counter.error_count)
+        {
+            return 5;
+        }
+    }
+
+    {
+        PacketXorDivider divider;
+        PacketXorUnifier unifier;
+        if (!divider.init(1100, false) || !unifier.init(100))
+        {
+            return 6;
+        }
+
+        int udp_socket = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in address;
+        memset(&address, 0x0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t address_size = sizeof(address);
+        struct timeval recv_timeout = { 0, 10000 };
+        if (udp_socket < 0 || 0 != bind(udp_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) || 0 != getsockname(udp_socket, reinterpret_cast<struct sockaddr *>(&address), &address_size) || 0 != setsockopt(udp_socket, SOL_SOCKET, SO_RCVTIMEO, &recv_timeout, sizeof(recv_timeout)))
+        {
+            return 7;
+        }
+
+        frame_counter_t counter = { static_cast<uint32_t>(src_data.size()), 0, 0 };
+        uint8_t recv_buffer[2048];
+
+        int32_t s1 = 0;
+        int32_t m1 = 0;
+        get_system_time(s1, m1);
+
+        for (uint32_t frame_index = 0; frame_index < frame_count; ++frame_index)
+        {
+            std::list<std::vector<uint8_t>> src_list;
+            if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+            {
+                close(udp_socket);
+                return 8;
+            }
+            for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+            {
+                sendto(udp_socket, &(*iter)[0], iter->size(), 0, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+            }
+            for (uint32_t retry = 0; counter.frame_count <= frame_index && retry < 100; )
+            {
+                ssize_t recv_size = recv(udp_socket, recv_buffer, sizeof(recv_buffer), 0);
+                if (recv_size > 0)
+                {
+                    unifier.decode(recv_buffer, static_cast<uint32_t>(recv_size), count_frame, &counter);
+                }
+                else
+                {
+                    unifier.decode(nullptr, 0, count_frame, &counter);
+                    ++retry;
+                }
+            }
+        }
+
+        int32_t s2 = 0;
+        int32_t m2 = 0;
+        get_system_time(s2, m2);
+
+        close(udp_socket);
+
+        int32_t delta12 = (s2 - s1) * 1000 + (m2 - m1) / 1000;
+        std::cout << "socket use time " << delta12 << "ms" << std::endl;
+
+        if (frame_count != counter.frame_count || 0 != counter.error_count)
+        {
+            return 9;
+        }
+    }
+#endif // __linux__
+
+    return 0;
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+struct detached_task_t
+{
+    struct promise_type
+    {
+        detached_task_t get_return_object() { return detached_task_t(); }
+        std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct wire_t
+{
+    std::list<std::vector<uint8_t>>     datagrams;
+    std::size_t                         capacity;
+};
+
+static bool transmit_datagram(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    wire_t * wire = reinterpret_cast<wire_t *>(user_data);
+    if (wire->datagrams.size() >= wire->capacity)
+    {
+        return false;
+    }
+    wire->datagrams.emplace_back(dst_data, dst_data + dst_size);
+    return true;
+}
+
+static detached_task_t send_frames(PacketXorCoroDivider & divider, const std::vector<uint8_t> & src_data, uint32_t frame_count, uint32_t & sent_count)
+{
+    for (uint32_t frame_index = 0; frame_index < frame_count; ++frame_index)
+    {
+        if (!co_await divider.send(&src_data[0], static_cast<uint32_t>(src_data.size())))
+        {
+            break;
+        }
+        ++sent_count;
+    }
+}
+
+static detached_task_t receive_frames(PacketXorCoroUnifier & unifier, const std::vector<uint8_t> & src_data, uint32_t & recv_count)
+{
+    for (;;)
+    {
+        PacketXorFrame frame = co_await unifier.next_frame();
+        if (!frame)
+        {
+            break;
+        }
+        if (frame.size() == src_data.size() && 0 == memcmp(frame.data(), &src_data[0], frame.size()))
+        {
+            ++recv_count;
+        }
+    }
+}
+#endif // __cpp_impl_coroutine
+
+int test_11()
+{
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+    std::vector<uint8_t> src_data(32000, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(1100, true) || !unifier.init(100))
+    {
+        return 1;
+    }
+
+    const uint32_t frame_count = 100;
+    uint32_t sent_count = 0;
+    uint32_t recv_count = 0;
+    wire_t wire = { std::list<std::vector<uint8_t>>(), 16 };
+    PacketXorCoroDivider coro_divider(divider, transmit_datagram, &wire, 64 * 1024);
+    PacketXorCoroUnifier coro_unifier(unifier);
+
+    receive_frames(coro_unifier, src_data, recv_count);
+    send_frames(coro_divider, src_data, frame_count, sent_count);
+
+    if (sent_count >= frame_count)
+    {
+        return 2;
+    }
+
+    for (uint32_t loop = 0; loop < 100000 && recv_count < frame_count; ++loop)
+    {
+        while (!wire.datagrams.empty())
+        {
+            const std::vector<uint8_t> & data = wire.datagrams.front();
+            coro_unifier.feed(&data[0], static_cast<uint32_t>(data.size()));
+            wire.datagrams.pop_front();
+        }
+        coro_divider.flush();
+    }
+
+    coro_unifier.close();
+
+    if (frame_count != sent_count || frame_count != recv_count || 0 != coro_divider.queue_bytes())
+    {
+        return 3;
+    }
+#endif // __cpp_impl_coroutine
+
+    return 0;
+}
+
+struct object_feed_t
+{
+    PacketXorUnifier                  * unifier;
+    uint32_t                            datagram_index;
+};
+
+static void feed_object_block(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    object_feed_t * feed = reinterpret_cast<object_feed_t *>(user_data);
+    if (0 != feed->datagram_index++ % 7)
+    {
+        std::list<std::vector<uint8_t>> dst_list;
+        feed->unifier->decode(dst_data, dst_size, dst_list);
+    }
+}
+
+int test_12()
+{
+#ifndef _MSC_VER
+    std::vector<uint8_t> src_data(3 * 1024 * 1024 + 12345, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    char src_path[] = "/tmp/packet_xor_src_XXXXXX";
+    char dst_path[] = "/tmp/packet_xor_dst_XXXXXX";
+    int src_file = mkstemp(src_path);
+    int dst_file = mkstemp(dst_path);
+    if (src_file < 0 || dst_file < 0)
+    {
+        return 1;
+    }
+    close(dst_file);
+
+    int ret = 0;
+    if (static_cast<ssize_t>(src_data.size()) != write(src_file, &src_data[0], src_data.size()))
+    {
+        ret = 2;
+    }
+    else
+    {
+        const uint32_t window_size = 256 * 1024;
+        PacketXorDivider divider;
+        PacketXorUnifier unifier;
+        object_feed_t feed = { &unifier, 0 };
+        unifier_stats_t stats;
+        if (!divider.init(1100, true) || !unifier.init(1000, 0.0, 4 * window_size) || !unifier.set_object_output(dst_path))
+        {
+            ret = 3;
+        }
+        else if (!divider.encode_object(src_file, src_data.size(), window_size, feed_object_block, &feed))
+        {
+            ret = 4;
+        }
+        else
+        {
+            unifier.get_stats(stats);
+            unifier.exit();
+            if ((src_data.size() + window_size - 1) / window_size != stats.object_windows || 0 != stats.object_dropped_windows || stats.memory_peak_bytes > 2 * window_size)
+            {
+                ret = 5;
+            }
+
+            std::vector<uint8_t> dst_data(src_data.size() + 1, 0x0);
+            int dst_read = open(dst_path, O_RDONLY);
+            if (0 == ret && (dst_read < 0 || static_cast<ssize_t>(src_data.size()) != read(dst_read, &dst_data[0], dst_data.size()) || 0 != memcmp(&src_data[0], &dst_data[0], src_data.size())))
+            {
+                ret = 6;
+            }
+            if (dst_read >= 0)
+            {
+                close(dst_read);
+            }
+        }
+    }
+
+    close(src_file);
+    unlink(src_path);
+    unlink(dst_path);
+
+    return ret;
+#else
+    return 0;
+#endif // _MSC_VER
+}
+
+struct progress_sink_t
+{
+    std::vector<uint8_t>                data;
+    uint32_t                            complete_count;
+    bool                                delivered;
+    bool                                ordered;
+};
+
+static void progress_frame(void * user_data, uint64_t group_index, uint32_t group_offset, const uint8_t * data, uint32_t size, uint32_t group_size)
+{
+    progress_sink_t * sink = reinterpret_cast<progress_sink_t *>(user_data);
+    if (group_offset != sink->data.size() || group_offset + size > group_size)
+    {
+        sink->ordered = false;
+    }
+    sink->data.insert(sink->data.end(), data, data + size);
+}
+
+static void complete_frame(void * user_data, uint64_t group_index, uint32_t group_size, bool delivered)
+{
+    progress_sink_t * sink = reinterpret_cast<progress_sink_t *>(user_data);
+    sink->complete_count += 1;
+    sink->delivered = delivered;
+}
+
+int test_13()
+{
+    std::vector<uint8_t> src_data(307608, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    progress_sink_t sink = { std::vector<uint8_t>(), 0, false, true };
+    if (!divider.init(1100, false) || !unifier.init(1000) || !unifier.set_progress(progress_frame, complete_frame, &sink))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> src_list;
+    if (!divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size()), src_list))
+    {
+        return 2;
+    }
+
+    std::vector<uint8_t> held_block;
+    std::list<std::vector<uint8_t>> dst_list;
+    std::size_t prefix_bytes = 0;
+    uint32_t block_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter, ++block_index)
+    {
+        if (100 == block_index)
+        {
+            held_block = *iter;
+            prefix_bytes = sink.data.size();
+            continue;
+        }
+        unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+    }
+
+    if (0 == prefix_bytes || prefix_bytes != sink.data.size() || 0 != sink.complete_count)
+    {
+        return 3;
+    }
+
+    unifier.decode(&held_block[0], static_cast<uint32_t>(held_block.size()), dst_list);
+
+    if (!dst_list.empty() || 1 != sink.complete_count || !sink.delivered || !sink.ordered || sink.data != src_data)
+    {
+        return 4;
+    }
+
+    return 0;
+}
+
+int test_14()
+{
+    std::vector<uint8_t> src_data(20000, 0x0);
+    for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+    {
+        *iter = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorDivider list_divider;
+    PacketXorDivider batch_divider;
+    PacketXorUnifier unifier;
+    if (!list_divider.init(1100, true, true) || !batch_divider.init(1100, true, true) || !unifier.init(1000))
+    {
+        return 1;
+    }
+
+    PacketBatch src_batch;
+    const uint8_t * arena = nullptr;
+    for (uint32_t frame_index = 0; frame_index < 8; ++frame_index)
+    {
+        const uint32_t frame_size = (3 == frame_index % 4 ? 100 : static_cast<uint32_t>(src_data.size()) - frame_index * 1000);
+
+        std::list<std::vector<uint8_t>> src_list;
+        src_batch.clear();
+        if (!list_divider.encode(&src_data[0], frame_size, src_list) || !batch_divider.encode(&src_data[0], frame_size, src_batch))
+        {
+            return 2;
+        }
+
+        if (src_list.size() != src_batch.size())
+        {
+            return 3;
+        }
+
+        std::size_t packet_index = 0;
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter, ++packet_index)
+        {
+            if (iter->size() != src_batch.length(packet_index) || 0 != memcmp(&(*iter)[0], src_batch.data(packet_index), iter->size()))
+            {
+                return 4;
+            }
+        }
+
+        if (frame_index > 0 && src_batch.arena() != arena)
+        {
+            return 5;
+        }
+        arena = src_batch.arena();
+
+#ifdef __linux__
+        std::vector<struct iovec> iovecs(src_batch.size());
+        std::vector<struct mmsghdr> messages(src_batch.size());
+        for (packet_index = 0; packet_index < src_batch.size(); ++packet_index)
+        {
+            iovecs[packet_index].iov_base = const_cast<uint8_t *>(src_batch.data(packet_index));
+            iovecs[packet_index].iov_len = src_batch.length(packet_index);
+            memset(&messages[packet_index], 0x0, sizeof(messages[packet_index]));
+            messages[packet_index].msg_hdr.msg_iov = &iovecs[packet_index];
+            messages[packet_index].msg_hdr.msg_iovlen = 1;
+        }
+#endif // __linux__
+
+        PacketBatch dst_batch;
+        for (packet_index = 0; packet_index < src_batch.size(); ++packet_index)
+        {
+            unifier.decode(src_batch.data(packet_index), src_batch.length(packet_index), dst_batch);
+        }
+
+        if (1 != dst_batch.size() || frame_size != dst_batch.length(0) || 0 != memcmp(&src_data[0], dst_batch.data(0), frame_size))
+        {
+            return 6;
+        }
+    }
+
+    return 0;
+}
+
+int test_15()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(1100, true, true) || !divider.set_cross_parity(4, 20) || !unifier.init(50))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(40);
+    std::list<std::vector<uint8_t>> src_list;
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(60 + frame_index * 7);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_list))
+        {
+            return 2;
+        }
+    }
+
+    if (src_frames.size() + src_frames.size() / 4 != src_list.size())
+    {
+        return 3;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    std::size_t packet_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter, ++packet_index)
+    {
+        if (6 == packet_index || 17 == packet_index || 26 == packet_index || 27 == packet_index)
+        {
+            continue;
+        }
+        unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+    }
+
+    sleep_millisecond(60);
+    unifier.decode(nullptr, 0, dst_list);
+
+    unifier_stats_t stats = { 0x0 };
+    unifier.get_stats(stats);
+    if (2 != stats.parity_recovered_groups || src_frames.size() - 2 != dst_list.size())
+    {
+        return 4;
+    }
+
+    std::size_t frame_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = dst_list.begin(); dst_list.end() != iter; ++iter, ++frame_index)
+    {
+        if (21 == frame_index)
+        {
+            frame_index += 2;
+        }
+        if (*iter != src_frames[frame_index])
+        {
+            return 5;
+        }
+    }
+
+    return 0;
+}
+
+static void collect_frame(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    std::list<std::vector<uint8_t>> * dst_list = reinterpret_cast<std::list<std::vector<uint8_t>> *>(user_data);
+    dst_list->emplace_back(dst_data, dst_data + dst_size);
+}
+
+int test_16()
+{
+#ifndef _MSC_VER
+    char payload_path[] = "/tmp/packet_xor_trace_XXXXXX";
+    char header_path[] = "/tmp/packet_xor_trace_XXXXXX";
+    int payload_file = mkstemp(payload_path);
+    int header_file = mkstemp(header_path);
+    if (payload_file < 0 || header_file < 0)
+    {
+        return 1;
+    }
+    close(payload_file);
+    close(header_file);
+
+    PacketXorDivider divider;
+    PacketXorUnifier payload_unifier;
+    PacketXorUnifier header_unifier;
+    if (!divider.init(1100, false) || !payload_unifier.init(10) || !header_unifier.init(10) || !payload_unifier.set_trace(payload_path, true) || !header_unifier.set_trace(header_path))
+    {
+        return 2;
+    }
+
+    std::vector<uint8_t> src_data(5000, 0x0);
+    std::list<std::vector<uint8_t>> payload_live_list;
+    std::list<std::vector<uint8_t>> header_live_list;
+    uint32_t decode_count = 0;
+    for (uint32_t frame_index = 0; frame_index < 30; ++frame_index)
+    {
+        for (std::vector<uint8_t>::iterator iter = src_data.begin(); src_data.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        std::list<std::vector<uint8_t>> src_list;
+        divider.encode(&src_data[0], static_cast<uint32_t>(src_data.size() - frame_index * 10), src_list);
+
+        uint32_t block_index = 0;
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter, ++block_index)
+        {
+            if (2 == block_index && (5 == frame_index || 17 == frame_index))
+            {
+                continue;
+            }
+            payload_unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), collect_frame, &payload_live_list);
+            header_unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), collect_frame, &header_live_list);
+            ++decode_count;
+        }
+
+        if (4 == frame_index % 5)
+        {
+            sleep_millisecond(6);
+            payload_unifier.decode(nullptr, 0, collect_frame, &payload_live_list);
+            header_unifier.decode(nullptr, 0, collect_frame, &header_live_list);
+            ++decode_count;
+        }
+    }
+
+    payload_unifier.set_trace(nullptr);
+    header_unifier.set_trace(nullptr);
+
+    int ret = 0;
+    PacketXorUnifier replay_unifier;
+    std::list<std::vector<uint8_t>> payload_replay_list;
+    std::list<std::vector<uint8_t>> header_replay_list;
+    replay_stats_t payload_stats = { 0x0 };
+    replay_stats_t header_stats = { 0x0 };
+    if (!replay_unifier.init(10) || !replay_unifier.replay(payload_path, collect_frame, &payload_replay_list, payload_stats) || !replay_unifier.replay(header_path, collect_frame, &header_replay_list, header_stats))
+    {
+        ret = 3;
+    }
+    else if (payload_live_list.size() >= 30 || payload_live_list != payload_replay_list || payload_stats.trace_records != decode_count || payload_stats.delivered_frames != payload_live_list.size())
+    {
+        ret = 4;
+    }
+    else if (header_live_list.size() != header_replay_list.size() || header_stats.trace_records != decode_count || 0 == header_stats.trace_microseconds)
+    {
+        ret = 5;
+    }
+    else
+    {
+        std::list<std::vector<uint8_t>>::const_iterator header_iter = header_replay_list.begin();
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = header_live_list.begin(); header_live_list.end() != iter; ++iter, ++header_iter)
+        {
+            if (iter->size() != header_iter->size())
+            {
+                ret = 6;
+            }
+        }
+    }
+
+    unlink(payload_path);
+    unlink(header_path);
+
+    return ret;
+#else
+    return 0;
+#endif // _MSC_VER
+}
+
+struct stripe_sink_t
+{
+    std::list<std::pair<uint32_t, std::vector<uint8_t>>>    packets;
+    uint32_t                                                path_counts[3];
+};
+
+static void stripe_packet(void * user_data, uint32_t path_index, const uint8_t * dst_data, uint32_t dst_size)
+{
+    stripe_sink_t * sink = reinterpret_cast<stripe_sink_t *>(user_data);
+    sink->packets.emplace_back(path_index, std::vector<uint8_t>(dst_data, dst_data + dst_size));
+    sink->path_counts[path_index] += 1;
+}
+
+int test_17()
+{
+    const uint32_t path_weights[3] = { 2, 1, 1 };
+    stripe_sink_t sink;
+    memset(sink.path_counts, 0x0, sizeof(sink.path_counts));
+
+    PacketXorDivider divider;
+    PacketXorStriper striper;
+    PacketXorUnifier unifier;
+    if (!divider.init(500, true, true) || !striper.init(3, path_weights, &stripe_packet, &sink) || !unifier.init(50))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(30);
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(0 == frame_index % 5 ? 100 : 400 + frame_index * 97);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), &PacketXorStriper::stripe_block, &striper))
+        {
+            return 2;
+        }
+    }
+
+    if (0 == sink.path_counts[1] || sink.path_counts[0] <= sink.path_counts[2])
+    {
+        return 3;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    for (std::list<std::pair<uint32_t, std::vector<uint8_t>>>::const_iterator iter = sink.packets.begin(); sink.packets.end() != iter; ++iter)
+    {
+        if (1 == iter->first)
+        {
+            continue;
+        }
+        if (!PacketXorUnifier::recognizable(&iter->second[0], static_cast<uint32_t>(iter->second.size())))
+        {
+            return 4;
+        }
+        unifier.decode(&iter->second[0], static_cast<uint32_t>(iter->second.size()), dst_list);
+    }
+
+    if (dst_list.size() != src_frames.size() || !std::equal(dst_list.begin(), dst_list.end(), src_frames.begin()))
+    {
+        return 5;
+    }
+
+    path_stats_t path_stats[3];
+    for (uint32_t path_index = 0; path_index < 3; ++path_index)
+    {
+        if (!unifier.get_path_stats(path_index, path_stats[path_index]))
+        {
+            return 6;
+        }
+    }
+    if (sink.path_counts[0] != path_stats[0].received_blocks || 0 != path_stats[0].lost_blocks || 0 != path_stats[1].received_blocks || sink.path_counts[2] != path_stats[2].received_blocks || 0 != path_stats[2].lost_blocks)
+    {
+        return 7;
+    }
+
+    PacketXorUnifier single_unifier;
+    if (!single_unifier.init(50))
+    {
+        return 8;
+    }
+    uint32_t path_packet_index = 0;
+    for (std::list<std::pair<uint32_t, std::vector<uint8_t>>>::const_iterator iter = sink.packets.begin(); sink.packets.end() != iter; ++iter)
+    {
+        if (0 == iter->first && 3 != path_packet_index++)
+        {
+            single_unifier.decode(&iter->second[0], static_cast<uint32_t>(iter->second.size()), dst_list);
+        }
+    }
+    if (!single_unifier.get_path_stats(0, path_stats[0]) || 1 != path_stats[0].lost_blocks || 0.0 != path_stats[0].relative_delay_microseconds)
+    {
+        return 9;
+    }
+
+    striper.reset();
+    sink.packets.clear();
+    memset(sink.path_counts, 0x0, sizeof(sink.path_counts));
+    if (!striper.set_path_capacity(0, 0.0) || !divider.encode(&src_frames[1][0], static_cast<uint32_t>(src_frames[1].size()), &PacketXorStriper::stripe_block, &striper))
+    {
+        return 10;
+    }
+    if (0 != sink.path_counts[0] || 0 == sink.path_counts[1] || 0 == sink.path_counts[2])
+    {
+        return 11;
+    }
+
+    stripe_sink_t xor_sink;
+    memset(xor_sink.path_counts, 0x0, sizeof(xor_sink.path_counts));
+    PacketXorDivider xor_divider;
+    PacketXorStriper xor_striper;
+    if (!xor_divider.init(300, true) || !xor_striper.init(3, path_weights, &stripe_packet, &xor_sink))
+    {
+        return 12;
+    }
+
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        if (!xor_divider.encode(&src_frames[frame_index][0], static_cast<uint32_t>(src_frames[frame_index].size()), &PacketXorStriper::stripe_block, &xor_striper))
+        {
+            return 13;
+        }
+    }
+
+    for (uint32_t dead_path = 0; dead_path < 3; ++dead_path)
+    {
+        PacketXorUnifier path_unifier;
+        if (!path_unifier.init(50))
+        {
+            return 14;
+        }
+
+        dst_list.clear();
+        for (std::list<std::pair<uint32_t, std::vector<uint8_t>>>::const_iterator iter = xor_sink.packets.begin(); xor_sink.packets.end() != iter; ++iter)
+        {
+            if (dead_path != iter->first)
+            {
+                path_unifier.decode(&iter->second[0], static_cast<uint32_t>(iter->second.size()), dst_list);
+            }
+        }
+
+        if (dst_list.size() != src_frames.size() || !std::equal(dst_list.begin(), dst_list.end(), src_frames.begin()))
+        {
+            return 15;
+        }
+    }
+
+    PacketXorUnifier offset_unifier;
+    if (!offset_unifier.init(50))
+    {
+        return 16;
+    }
+
+    for (uint32_t packet_index = 0; packet_index < 8; ++packet_index)
+    {
+        const std::vector<uint8_t> & src_frame = src_frames[0];
+        std::list<std::vector<uint8_t>> block_list;
+        if (!xor_divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), block_list))
+        {
+            return 17;
+        }
+
+        const uint32_t path_index = packet_index % 2;
+        const uint32_t send_time = static_cast<uint32_t>(PacketXorUnifier::current_microsecond()) - 0x80000000u + (0 == packet_index % 4 ? 100 : 0) - (1 == packet_index % 4 ? 100 : 0);
+        const uint8_t path_head[16] = { 0, 0, 0, 0, 0, 0, 0, static_cast<uint8_t>(packet_index / 2), 0xed, static_cast<uint8_t>(path_index), 0, 0, static_cast<uint8_t>(send_time >> 24), static_cast<uint8_t>(send_time >> 16), static_cast<uint8_t>(send_time >> 8), static_cast<uint8_t>(send_time) };
+        std::vector<uint8_t> path_data(path_head, path_head + sizeof(path_head));
+        path_data.insert(path_data.end(), block_list.front().begin(), block_list.front().end());
+        offset_unifier.decode(&path_data[0], static_cast<uint32_t>(path_data.size()), dst_list);
+    }
+
+    for (uint32_t path_index = 0; path_index < 2; ++path_index)
+    {
+        if (!offset_unifier.get_path_stats(path_index, path_stats[path_index]) || 4 != path_stats[path_index].received_blocks || path_stats[path_index].relative_delay_microseconds > 100 * 1000 || path_stats[path_index].jitter_microseconds > 100 * 1000)
+        {
+            return 18;
+        }
+    }
+
+    return 0;
+}
+
+int test_18()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier eager_unifier;
+    PacketXorUnifier lazy_unifier;
+    if (!divider.init(228, true) || !eager_unifier.init(50) || !lazy_unifier.init(50) || !lazy_unifier.set_lazy_recovery(true))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(20);
+    std::list<std::vector<uint8_t>> eager_list;
+    std::list<std::vector<uint8_t>> lazy_list;
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(1500 + frame_index * 13);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        std::list<std::vector<uint8_t>> src_list;
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_list) || src_list.size() < 10)
+        {
+            return 2;
+        }
+
+        std::vector<std::vector<uint8_t>> recv_packets;
+        std::size_t seq_index = 0;
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+        {
+            if (0xe9 == (*iter)[8] && 3 == seq_index++ && 0 == frame_index % 2)
+            {
+                continue;
+            }
+            recv_packets.push_back(*iter);
+            if (0xea == (*iter)[8] && recv_packets.size() > 1)
+            {
+                recv_packets.back().swap(recv_packets[recv_packets.size() - 2]);
+            }
+        }
+
+        for (std::vector<std::vector<uint8_t>>::const_iterator iter = recv_packets.begin(); recv_packets.end() != iter; ++iter)
+        {
+            eager_unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), eager_list);
+            lazy_unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), lazy_list);
+        }
+    }
+
+    if (src_frames.size() != eager_list.size() || !std::equal(eager_list.begin(), eager_list.end(), src_frames.begin()))
+    {
+        return 3;
+    }
+
+    if (src_frames.size() != lazy_list.size() || !std::equal(lazy_list.begin(), lazy_list.end(), src_frames.begin()))
+    {
+        return 4;
+    }
+
+    unifier_stats_t eager_stats = { 0x0 };
+    unifier_stats_t lazy_stats = { 0x0 };
+    eager_unifier.get_stats(eager_stats);
+    lazy_unifier.get_stats(lazy_stats);
+    if (0 == lazy_stats.xor_processed_bytes || lazy_stats.xor_processed_bytes * 4 > eager_stats.xor_processed_bytes || 0 != lazy_stats.memory_used_bytes)
+    {
+        return 5;
+    }
+
+    return 0;
+}
+
+int test_19()
+{
+#ifdef __linux__
+    if (!PacketXorShmWriter::supported())
+    {
+        return 0;
+    }
+
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    PacketXorShmWriter writer;
+    if (!divider.init(1100, true) || !unifier.init(50) || !writer.init(&unifier, 4, 4096))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(12);
+    std::vector<std::list<std::vector<uint8_t>>> src_lists(src_frames.size());
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(5 == frame_index ? 5000 : 300 + frame_index * 311);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_lists[frame_index]))
+        {
+            return 2;
+        }
+    }
+
+    PacketXorShmReader reader;
+    if (!reader.init(writer.memory_fd(), writer.event_fd()))
+    {
+        return 3;
+    }
+
+    for (std::size_t frame_index = 0; frame_index < 6; ++frame_index)
+    {
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_lists[frame_index].begin(); src_lists[frame_index].end() != iter; ++iter)
+        {
+            writer.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()));
+        }
+    }
+
+    shm_stats_t stats = { 0x0 };
+    writer.get_stats(stats);
+    if (4 != stats.published_frames || 1 != stats.dropped_frames || 1 != stats.oversize_frames)
+    {
+        return 4;
+    }
+
+    shm_frame_t frame = { 0x0 };
+    for (uint64_t frame_index = 0; frame_index < 4; ++frame_index)
+    {
+        if (!reader.acquire(frame) || frame_index != frame.sequence || frame.size != src_frames[frame_index].size() || 0 != memcmp(frame.data, &src_frames[frame_index][0], frame.size))
+        {
+            return 5;
+        }
+    }
+    if (reader.acquire(frame) || reader.wait(0))
+    {
+        return 6;
+    }
+    while (reader.release())
+    {
+    }
+
+    const pid_t child = fork();
+    if (child < 0)
+    {
+        return 7;
+    }
+
+    if (0 == child)
+    {
+        std::size_t frame_index = 6;
+        while (frame_index < src_frames.size() && reader.wait(2000))
+        {
+            while (reader.acquire(frame))
+            {
+                if (frame.size != src_frames[frame_index].size() || 0 != memcmp(frame.data, &src_frames[frame_index][0], frame.size))
+                {
+                    _exit(1);
+                }
+                reader.release();
+                ++frame_index;
+            }
+        }
+        _exit(src_frames.size() == frame_index ? 0 : 2);
+    }
+
+    sleep_millisecond(20);
+    for (std::size_t frame_index = 6; frame_index < src_frames.size(); ++frame_index)
+    {
+        for (std::list<std::vector<uint8_t>>::const_iterator iter = src_lists[frame_index].begin(); src_lists[frame_index].end() != iter; ++iter)
+        {
+            writer.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()));
+        }
+        sleep_millisecond(1);
+    }
+
+    int status = 0;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || 0 != WEXITSTATUS(status))
+    {
+        return 8;
+    }
+
+    writer.get_stats(stats);
+    if (10 != stats.published_frames || 0 == stats.wakeups)
+    {
+        return 9;
+    }
+#endif // __linux__
+
+    return 0;
+}
+
+int test_20()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(300, false) || !divider.set_stream_fec(16, 4) || !unifier.init(50))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(40);
+    std::list<std::vector<uint8_t>> src_list;
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(200 + frame_index * 37 % 900);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_list))
+        {
+            return 2;
+        }
+    }
+
+    std::size_t source_index = 0;
+    std::size_t drop_count = 0;
+    std::list<std::vector<uint8_t>> dst_list;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+    {
+        if (0xee == (*iter)[8] && 5 == source_index++ % 11 && source_index + 32 < src_list.size())
+        {
+            ++drop_count;
+            continue;
+        }
+        unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+    }
+
+    if (0 == drop_count || src_frames.size() != dst_list.size() || !std::equal(dst_list.begin(), dst_list.end(), src_frames.begin()))
+    {
+        return 3;
+    }
+
+    unifier_stats_t stats = { 0x0 };
+    unifier.get_stats(stats);
+    if (drop_count != stats.stream_recovered_blocks)
+    {
+        return 4;
+    }
+
+    return 0;
+}
+
+int test_21()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(300, false) || !unifier.init(20, 0.5))
+    {
+        return 1;
+    }
+
+    if (0 != unifier.next_deadline())
+    {
+        return 2;
+    }
+
+    std::vector<uint8_t> src_frame(2000, 0x5a);
+    std::list<std::vector<uint8_t>> src_list;
+    if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_list) || src_list.size() < 4)
+    {
+        return 3;
+    }
+
+    const uint64_t start_time = PacketXorUnifier::current_microsecond();
+    std::list<std::vector<uint8_t>> dst_list;
+    std::size_t block_index = 0;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = src_list.begin(); src_list.end() != iter; ++iter)
+    {
+        if (2 != block_index++)
+        {
+            unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+        }
+    }
+
+    const uint64_t deadline = unifier.next_deadline();
+    if (!dst_list.empty() || deadline < start_time + 20 * 1000 || deadline > PacketXorUnifier::current_microsecond() + 20 * 1000 + 1)
+    {
+        return 4;
+    }
+
+    if (unifier.poll(deadline - 1, dst_list) || !dst_list.empty())
+    {
+        return 5;
+    }
+
+    if (!unifier.poll(deadline, dst_list) || 1 != dst_list.size() || src_frame.size() != dst_list.front().size())
+    {
+        return 6;
+    }
+
+    if (0 != unifier.next_deadline())
+    {
+        return 7;
+    }
+
+    const uint64_t steady_time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    const uint64_t current_time = PacketXorUnifier::current_microsecond();
+    if (current_time < steady_time || current_time > steady_time + 1000 * 1000)
+    {
+        return 8;
+    }
+
+    return 0;
+}
+
+int test_22()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(300, true, true) || !divider.set_stream_fec(8, 4) || !unifier.init(50))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(12);
+    PacketBatch src_batch;
+    std::size_t junk_count = 0;
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(100 + frame_index * 211);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        if (!divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), src_batch))
+        {
+            return 2;
+        }
+
+        uint8_t junk[48];
+        for (std::size_t index = 0; index < sizeof(junk); ++index)
+        {
+            junk[index] = static_cast<uint8_t>(rand());
+        }
+        junk[8] = static_cast<uint8_t>(0 == frame_index % 2 ? 0xe9 + frame_index % 7 : 0x10 + frame_index);
+        src_batch.append(junk, static_cast<uint32_t>(4 + frame_index * 4));
+        ++junk_count;
+    }
+
+    std::vector<uint64_t> valid_mask;
+    std::vector<block_view_t> block_views;
+    const std::size_t valid_count = PacketXorUnifier::classify(src_batch, valid_mask, block_views);
+    if (src_batch.size() != block_views.size() || valid_count + junk_count != src_batch.size())
+    {
+        return 3;
+    }
+
+    for (std::size_t packet_index = 0; packet_index < src_batch.size(); ++packet_index)
+    {
+        const bool valid = (0 != (valid_mask[packet_index / 64] & (1ULL << (packet_index % 64))));
+        if (valid != PacketXorUnifier::recognizable(src_batch.data(packet_index), src_batch.length(packet_index)) || valid != (0 != block_views[packet_index].protocol_id))
+        {
+            return 4;
+        }
+    }
+
+    std::vector<block_view_t> broken_views(block_views);
+    for (std::vector<block_view_t>::iterator iter = broken_views.begin(); broken_views.end() != iter; ++iter)
+    {
+        iter->block_bytes += (0xe9 == iter->protocol_id ? 1 : 0);
+    }
+
+    PacketBatch dst_batch;
+    PacketXorUnifier broken_unifier;
+    if (!broken_unifier.init(50))
+    {
+        return 5;
+    }
+
+    broken_unifier.decode(src_batch, broken_views, dst_batch);
+    for (std::size_t packet_index = 0, frame_index = 0; packet_index < dst_batch.size(); ++packet_index, ++frame_index)
+    {
+        while (frame_index < src_frames.size() && src_frames[frame_index].size() != dst_batch.length(packet_index))
+        {
+            ++frame_index;
+        }
+        if (frame_index == src_frames.size() || 0 != memcmp(&src_frames[frame_index][0], dst_batch.data(packet_index), dst_batch.length(packet_index)))
+        {
+            return 5;
+        }
+    }
+
+    dst_batch.clear();
+    if (!unifier.decode(src_batch, block_views, dst_batch) || src_frames.size() != dst_batch.size())
+    {
+        return 6;
+    }
+
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        if (src_frames[frame_index].size() != dst_batch.length(frame_index) || 0 != memcmp(&src_frames[frame_index][0], dst_batch.data(frame_index), dst_batch.length(frame_index)))
+        {
+            return 7;
+        }
+    }
+
+    return 0;
+}
+
+static void fanout_packets(void * user_data, uint32_t session_id, const fanout_packet_t * dst_packets, uint32_t dst_count)
+{
+    std::list<std::vector<uint8_t>> * sessions = reinterpret_cast<std::list<std::vector<uint8_t>> *>(user_data);
+    for (uint32_t packet_index = 0; packet_index < dst_count; ++packet_index)
+    {
+        const fanout_packet_t & packet = dst_packets[packet_index];
+        sessions[session_id].emplace_back(packet.head_data, packet.head_data + packet.head_size);
+        sessions[session_id].back().insert(sessions[session_id].back().end(), packet.body_data, packet.body_data + packet.body_size);
+    }
+}
+
+int test_23()
+{
+    PacketXorFanout fanout;
+    PacketXorDivider early_divider;
+    PacketXorDivider late_divider;
+    if (!fanout.init(300, true, true) || !early_divider.init(300, true, true) || !late_divider.init(300, true, true) || !fanout.add_session(1) || !fanout.add_session(2) || fanout.add_session(2))
+    {
+        return 1;
+    }
+
+    std::list<std::vector<uint8_t>> fanout_sessions[4];
+    std::list<std::vector<uint8_t>> early_list;
+    std::list<std::vector<uint8_t>> late_list;
+    for (std::size_t frame_index = 0; frame_index < 8; ++frame_index)
+    {
+        std::vector<uint8_t> src_frame(0 == frame_index % 3 ? 50 : 700 + frame_index * 101);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+
+        if (4 == frame_index && !fanout.add_session(3))
+        {
+            return 2;
+        }
+
+        if (!fanout.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size())) || !fanout.emit(&fanout_packets, fanout_sessions))
+        {
+            return 3;
+        }
+
+        early_divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), early_list);
+        if (frame_index >= 4)
+        {
+            late_divider.encode(&src_frame[0], static_cast<uint32_t>(src_frame.size()), late_list);
+        }
+    }
+
+    if (fanout_sessions[1] != early_list || fanout_sessions[2] != early_list || fanout_sessions[3] != late_list)
+    {
+        return 4;
+    }
+
+    std::vector<fanout_packet_t> first_packets;
+    std::vector<fanout_packet_t> second_packets;
+    if (!fanout.emit(1, first_packets) || !fanout.emit(2, second_packets) || first_packets.size() != second_packets.size() || fanout.emit(4, first_packets))
+    {
+        return 5;
+    }
+
+    for (std::size_t packet_index = 0; packet_index < first_packets.size(); ++packet_index)
+    {
+        if (first_packets[packet_index].body_data != second_packets[packet_index].body_data || first_packets[packet_index].head_data == second_packets[packet_index].head_data)
+        {
+            return 6;
+        }
+    }
+
+    if (!fanout.remove_session(2) || fanout.remove_session(2))
+    {
+        return 7;
+    }
+
+    return 0;
+}
+
+struct send_sink_t
+{
+    std::list<std::vector<uint8_t>>     packets;
+    std::size_t                         budget;
+};
+
+static bool send_packet(void * user_data, const uint8_t * dst_data, uint32_t dst_size)
+{
+    send_sink_t * sink = reinterpret_cast<send_sink_t *>(user_data);
+    if (0 == sink->budget)
+    {
+        return false;
+    }
+    sink->budget -= 1;
+    sink->packets.emplace_back(dst_data, dst_data + dst_size);
+    return true;
+}
+
+int test_24()
+{
+    PacketXorDivider divider;
+    PacketXorUnifier unifier;
+    if (!divider.init(300, true) || !divider.set_send_queue(0, 0, 20) || !divider.set_stream_fec(8, 2) || !unifier.init(50))
+    {
+        return 1;
+    }
+
+    std::vector<std::vector<uint8_t>> src_frames(7);
+    for (std::size_t frame_index = 0; frame_index < src_frames.size(); ++frame_index)
+    {
+        std::vector<uint8_t> & src_frame = src_frames[frame_index];
+        src_frame.resize(900 + frame_index * 50);
+        for (std::vector<uint8_t>::iterator iter = src_frame.begin(); src_frame.end() != iter; ++iter)
+        {
+            *iter = static_cast<uint8_t>(rand());
+        }
+    }
+
+    for (std::size_t frame_index = 0; frame_index < 5; ++frame_index)
+    {
+        if (!divider.enqueue(&src_frames[frame_index][0], static_cast<uint32_t>(src_frames[frame_index].size())))
+        {
+            return 2;
+        }
+    }
+
+    send_sink_t sink;
+    sink.budget = 3;
+    if (divider.send(&send_packet, &sink) || 3 != sink.packets.size())
+    {
+        return 3;
+    }
+
+    sleep_millisecond(30);
+
+    for (std::size_t frame_index = 5; frame_index < src_frames.size(); ++frame_index)
+    {
+        if (!divider.enqueue(&src_frames[frame_index][0], static_cast<uint32_t>(src_frames[frame_index].size())))
+        {
+            return 4;
+        }
+    }
+
+    sink.budget = 1000;
+    if (!divider.send(&send_packet, &sink))
+    {
+        return 5;
+    }
+
+    sender_stats_t stats = { 0x0 };
+    divider.get_send_stats(stats);
+    if (4 != stats.dropped_frames || 3 != stats.sent_frames || 0 != stats.queued_frames || 0 != stats.queued_bytes || stats.queue_delay_max_microseconds >= 20 * 1000)
+    {
+        return 6;
+    }
+
+    PacketBatch sent_batch;
+    std::list<std::vector<uint8_t>> dst_list;
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = sink.packets.begin(); sink.packets.end() != iter; ++iter)
+    {
+        sent_batch.append(&(*iter)[0], static_cast<uint32_t>(iter->size()));
+        unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+    }
+
+    std::vector<uint64_t> valid_mask;
+    std::vector<block_view_t> block_views;
+    PacketXorUnifier::classify(sent_batch, valid_mask, block_views);
+    uint64_t min_group_index = ~0ULL;
+    uint64_t max_group_index = 0;
+    for (std::vector<block_view_t>::const_iterator iter = block_views.begin(); block_views.end() != iter; ++iter)
+    {
+        if (0 != iter->block_count)
+        {
+            min_group_index = std::min<uint64_t>(min_group_index, iter->group_index);
+            max_group_index = std::max<uint64_t>(max_group_index, iter->group_index);
+        }
+    }
+
+    if (2 != max_group_index - min_group_index)
+    {
+        return 7;
+    }
+
+    if (3 != dst_list.size() || dst_list.front() != src_frames[0] || *std::next(dst_list.begin()) != src_frames[5] || dst_list.back() != src_frames[6])
+    {
+        return 8;
+    }
+
+    PacketXorDivider bounded_divider;
+    if (!bounded_divider.init(300, true) || !bounded_divider.set_send_queue(1500, 0, 0))
+    {
+        return 9;
+    }
+
+    if (!bounded_divider.enqueue(&src_frames[0][0], static_cast<uint32_t>(src_frames[0].size())) || bounded_divider.enqueue(&src_frames[1][0], static_cast<uint32_t>(src_frames[1].size())))
+    {
+        return 10;
+    }
+
+    bounded_divider.get_send_stats(stats);
+    if (1 != stats.queued_frames || 1 != stats.dropped_frames)
+    {
+        return 11;
+    }
+
+    PacketXorDivider aggregate_divider;
+    PacketXorUnifier aggregate_unifier;
+    if (!aggregate_divider.init(1100, true) || !aggregate_divider.set_aggregation(200, 1000) || !aggregate_divider.set_send_queue(0, 0, 0) || !aggregate_unifier.init(50))
+    {
+        return 12;
+    }
+
+    std::list<std::vector<uint8_t>> msg_list;
+    for (std::size_t frame_index = 0; frame_index < 3; ++frame_index)
+    {
+        msg_list.emplace_back(src_frames[frame_index].begin(), src_frames[frame_index].begin() + 50 + frame_index);
+        if (!aggregate_divider.enqueue(&msg_list.back()[0], static_cast<uint32_t>(msg_list.back().size())))
+        {
+            return 13;
+        }
+    }
+
+    send_sink_t aggregate_sink;
+    aggregate_sink.budget = 1000;
+    if (!aggregate_divider.send(&send_packet, &aggregate_sink) || aggregate_sink.packets.empty())
+    {
+        return 14;
+    }
+
+    dst_list.clear();
+    for (std::list<std::vector<uint8_t>>::const_iterator iter = aggregate_sink.packets.begin(); aggregate_sink.packets.end() != iter; ++iter)
+    {
+        aggregate_unifier.decode(&(*iter)[0], static_cast<uint32_t>(iter->size()), dst_list);
+    }
+
+    aggregate_divider.get_send_stats(stats);
+    if (dst_list != msg_list || 3 != stats.sent_frames || 0 != stats.failed_frames || 0 != stats.queued_frames)
+    {
+        return 15;
+    }
+
+    return 0;
+}
+
+int test_25()
+{
+    const uint8_t seq_head[28] = { 0, 0, 0, 0, 0, 0, 0, 7, 0xe9, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 50, 0, 0, 0, 200, 0, 0, 0, 250 };
+    const uint8_t xor_head[28] = { 0, 0, 0, 0, 0, 0, 0, 7, 0xea, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 50, 0, 0, 0, 200, 0, 0, 0, 250 };
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        PacketXorUnifier unifier;
+        if (!unifier.init(30) || !unifier.set_lazy_recovery(0 != lazy))
+        {
+            return 1;
+        }
+
+        std::vector<uint8_t> seq_data(28 + 100, 0x5a);
+        std::copy(seq_head, seq_head + sizeof(seq_head), seq_data.begin());
+        std::vector<uint8_t> xor_data(28 + 40000, 0x00);
+        std::copy(xor_head, xor_head + sizeof(xor_head), xor_data.begin());
+
+        std::list<std::vector<uint8_t>> dst_list;
+        if (unifier.decode(&seq_data[0], static_cast<uint32_t>(seq_data.size()), dst_list) || unifier.decode(&xor_data[0], static_cast<uint32_t>(xor_data.size()), dst_list))
+        {
+            return 2;
+        }
+
+        unifier_stats_t stats = { 0x0 };
+        unifier.get_stats(stats);
+        if (stats.memory_used_bytes > 64 * 1024)
+        {
+            return 3;
+        }
+
+        for (uint8_t block_index = 0; block_index < 2; ++block_index)
+        {
+            seq_data[11] = block_index;
+            seq_data[19] = 100;
+            seq_data[23] = static_cast<uint8_t>(block_index * 100);
+            unifier.decode(&seq_data[0], static_cast<uint32_t>(seq_data.size()), dst_list);
+        }
+
+        if (1 != dst_list.size() || std::vector<uint8_t>(250, 0x5a) != dst_list.front())
+        {
+            return 4;
+        }
+    }
+
+    const uint8_t padded_head[28] = { 0, 0, 0, 0, 0, 0, 0, 9, 0xe9, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 40, 0, 0, 0, 0, 0, 0, 0, 40 };
+    std::vector<uint8_t> padded_data(1100, 0x0);
+    std::copy(padded_head, padded_head + sizeof(padded_head), padded_data.begin());
+    for (std::size_t index = 0; index < 40; ++index)
+    {
+        padded_data[28 + index] = static_cast<uint8_t>(rand());
+    }
+
+    PacketXorUnifier unifier;
+    if (!unifier.init(30) || !PacketXorUnifier::recognizable(&padded_data[0], static_cast<uint32_t>(padded_data.size())))
+    {
+        return 5;
+    }
+
+    std::list<std::vector<uint8_t>> dst_list;
+    unifier.decode(&padded_data[0], static_cast<uint32_t>(padded_data.size()), dst_list);
+    unifier.decode(&padded_data[0], static_cast<uint32_t>(padded_data.size()), dst_list);
+    if (1 != dst_list.size() || std::vector<uint8_t>(padded_data.begin() + 28, padded_data.begin() + 68) != dst_list.front())
+    {
+        return 6;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    if (0 != test_1())
+    {
+        return 1;
+    }
+
+    if (0 != test_2())
+    {
+        return 2;
+    }
+
+    if (0 != test_3())
+    {
+        return 3;
+    }
+
+    if (0 != test_4())
+    {
+        return 4;
+    }
+
+    if (0 != test_5())
+    {
+        return 5;
+    }
+
+    if (0 != test_6())
+    {
+        return 6;
+    }
+
+    if (0 != test_7())
+    {
+        return 7;
+    }
+
+    if (0 != test_8())
+    {
+        return 8;
+    }
+
+    if (0 != test_9())
+    {
+        return 9;
+    }
+
+    if (0 != test_10())
+    {
+        return 10;
+    }
+
+    if (0 != test_11())
+    {
+        return 11;
+    }
+
+    if (0 != test_12())
+    {
+        return 12;
+    }
+
+    if (0 != test_13())
+    {
+        return 13;
+    }
+
+    if (0 != test_14())
+    {
+        return 14;
+    }
+
+    if (0 != test_15())
+    {
+        return 15;
+    }
+
+    if (0 != test_16())
+    {
+        return 16;
+    }
+
+    if (0 != test_17())
+    {
+        return 17;
+    }
+
+    if (0 != test_18())
+    {
+        return 18;
+    }
+
+    if (0 != test_19())
+    {
+        return 19;
+    }
+
+    if (0 != test_20())
+    {
+        return 20;
+    }
+
+    if (0 != test_21())
+    {
+        return 21;
+    }
+
+    if (0 != test_22())
+    {
+        return 22;
+    }
+
+    if (0 != test_23())
+    {
+        return 23;
+    }
+
+    if (0 != test_24())
+    {
+        return 24;
+    }
+
+    if (0 != test_25())
+    {
+        return 25;
+    }
+
     std::cout << "ok" << std::endl;
 
     return 0;